@@ -1,8 +1,15 @@
 #pragma once
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "imgui.h"
 
 using namespace std::literals; // To write chrono values as 5s instead of std::chrono::seconds{5} // NOLINT(*global-names-in-headers)
@@ -16,6 +23,14 @@ enum class Type {
     Info,
 };
 
+/// Progress of a task, between 0 and 1. It is shared between the thread that does the work and the notification, so that the progress can be updated from any thread, as often as you want, without calling change(): render_windows() reads it directly.
+using Progress = std::shared_ptr<std::atomic<float>>;
+
+inline auto make_progress(float initial_progress = 0.f) -> Progress
+{
+    return std::make_shared<std::atomic<float>>(initial_progress);
+}
+
 struct Notification {
     Type                                     type{Type::Info};
     std::string                              title{""};
@@ -24,6 +39,17 @@ struct Notification {
     std::optional<std::chrono::milliseconds> duration{5s};           /// Set to std::nullopt to have an infinite duration. You then need to call ImGuiNotify::close(notification_id) manually.
     bool                                     is_closable{true};
     bool                                     hovering_keeps_notification_alive{true}; /// While this is true, if the user hovers the notification it will reset its lifetime
+    /// Sending a notification identical to one that is still alive (see deduplication_key) doesn't create a new one: the existing one displays how many times it has been sent ("×37"), and its lifetime is reset.
+    /// The NotificationId returned by send() then refers to the existing notification, but only the ids of the 16 most recent duplicates are remembered, so that memory doesn't grow when a notification is spammed.
+    /// Older ones do nothing when passed to change() and close_xxx(), like the id of a dropped notification.
+    bool                                     deduplicate{false};                      /// Merges identical notifications into a single one
+    std::string                              deduplication_key{""};                   /// Only used if deduplicate is true. Notifications with the same (non-empty) key are considered identical. If empty, notifications with the same type, title and content are considered identical.
+    std::string                              source{""};                              /// Optional tag identifying who sent the notification, so that you can use set_rate_limit() on a specific source.
+    Progress                                 progress{};                              /// If set, a progress bar is displayed. See Progress.
+    /// Defaults to a priority based on the type: Info (0) < Success (1) < Warning (2) < Error (3).
+    /// When they can't all fit on screen, notifications with a higher priority are shown first, and they are the last ones to be dropped by OverflowPolicy::DropLowestPriority.
+    /// In single window mode, they are stacked below the ones with a lower priority, so that they are the ones visible when the window isn't scrolled.
+    std::optional<int>                       priority{};                              /// Higher priorities are shown first and dropped last
 };
 
 class NotificationId {
@@ -34,15 +60,16 @@ public:
     {}
 
 private:
-    friend class NotificationImpl;
+    friend auto generate_notification_id() -> NotificationId; // Used internally to create valid ids
     struct MakeValid {};
-    inline static uint64_t _next_id{1}; // 0 is an invalid ID, start at 1
+    static auto generate_id() -> uint64_t; // Thread-safe, and never returns 0
 
     explicit NotificationId(MakeValid)
-        : _id{_next_id++}
+        : _id{generate_id()}
     {}
 
-    friend void render_windows();
+    friend class NotificationImpl;
+    friend struct std::hash<NotificationId>;
     friend auto operator==(NotificationId const&, NotificationId const&) -> bool = default;
 
 private:
@@ -50,16 +77,59 @@ private:
 };
 
 /// Returns a NotificationId that can be used to change() or close_after_small_delay() the notification (e.g. if it has an infinite duration)
+/// If the notification is dropped because of a rate limit (see set_rate_limit()), or rejected because there are already Capacity::max_pending_commands pending commands, returns an invalid NotificationId, which you can still pass to change() and close_xxx(): they will just do nothing.
 /// This is thread-safe and can be called from any thread
 auto send(Notification) -> NotificationId;
 
+/// Sends all the notifications at once, which is cheaper than calling send() for each of them: they are all queued with a single synchronization operation
+/// The notifications are moved out of the span. Returns their ids, in the same order (see send())
+/// This is thread-safe and can be called from any thread
+auto send_batch(std::span<Notification>) -> std::vector<NotificationId>;
+
+struct RateLimit {
+    float notifications_per_second{1.f};
+    int   burst{5}; // Number of notifications that can be sent at once before the rate limit kicks in
+};
+
+/// Limits how often notifications of a given type can be sent. The notifications that exceed the limit are dropped by send(), and a single summary notification tells how many have been dropped.
+/// Pass std::nullopt to remove the limit. By default there is no limit.
+/// This is thread-safe and can be called from any thread
+void set_rate_limit(Type, std::optional<RateLimit>);
+
+/// Limits how often notifications with the given Notification::source can be sent. The notifications that exceed the limit are dropped by send(), and a single summary notification tells how many have been dropped.
+/// If a type also has a limit, notifications must respect both.
+/// Pass std::nullopt to remove the limit. By default there is no limit.
+/// This is thread-safe and can be called from any thread
+void set_rate_limit(std::string_view source, std::optional<RateLimit>);
+
+enum class OverflowPolicy {
+    DropOldest,         // The oldest notification is removed to make room for the new one
+    DropLowestPriority, // The notification with the lowest Notification::priority, or the oldest one among them, is removed to make room for the new one. If the new one has a lower priority than all the others, it is dropped instead.
+    RejectNew,          // The new notification is dropped
+    MergeIntoSummary,   // The new notification is dropped, and a single summary notification tells how many have been dropped
+};
+
+struct Capacity {
+    size_t         max_notifications{SIZE_MAX};    // Maximum number of notifications alive at the same time (shown, or waiting to be shown)
+    size_t         max_pending_commands{SIZE_MAX}; // Maximum number of send() / change() / close_xxx() that can be waiting for the next render_windows(). When this is reached, send() is rejected whatever the overflow_policy (pending commands can't be removed to make room for new ones), and only MergeIntoSummary reports it in the summary notification. The other commands are never rejected.
+    OverflowPolicy overflow_policy{OverflowPolicy::DropOldest};
+};
+
+/// Bounds the memory used by the notifications. By default there is no limit.
+/// The memory for `max_notifications` notifications is allocated upfront.
+/// Must be called from the thread that calls render_windows()
+void set_capacity(Capacity);
+
 /// Changes the content of a notification that has already been sent
 /// Does nothing if the notification has already been closed
+/// Changes are applied at the next render_windows(): if you change the same notification several times before that, only the last change is applied. And the changes that come before a close_immediately() are not applied at all.
+/// Changing a notification resets its lifetime, so a change that comes after close_after_small_delay() cancels the close.
 /// This is thread-safe and can be called from any thread
 void change(NotificationId, Notification);
 
 /// Starts the closing animation after a given `delay`
 /// Does nothing if the notification has already been closed
+/// A change() or set_duration() that comes after it cancels it, but set_title(), set_content() and set_type() don't
 /// This is thread-safe and can be called from any thread
 void close_after_small_delay(NotificationId, std::chrono::milliseconds delay = 1s);
 
@@ -68,9 +138,87 @@ void close_after_small_delay(NotificationId, std::chrono::milliseconds delay = 1
 /// This is thread-safe and can be called from any thread
 void close_immediately(NotificationId);
 
+/// Like change(), but only changes the title, which avoids copying the rest of the notification
+/// Does nothing if the notification has already been closed
+/// This is thread-safe and can be called from any thread
+void set_title(NotificationId, std::string title);
+
+/// Like change(), but only changes the content, which avoids copying the rest of the notification
+/// Does nothing if the notification has already been closed
+/// This is thread-safe and can be called from any thread
+void set_content(NotificationId, std::string content);
+
+/// Like change(), but only changes the type. Since this doesn't change the size of the notification, there is no change transition.
+/// Does nothing if the notification has already been closed
+/// This is thread-safe and can be called from any thread
+void set_type(NotificationId, Type);
+
+/// Changes how long the notification stays visible (counted from when it appeared). Set to std::nullopt to have an infinite duration.
+/// Unlike change(), this doesn't reset the lifetime of the notification, and there is no change transition.
+/// Does nothing if the notification has already been closed
+/// This is thread-safe and can be called from any thread
+void set_duration(NotificationId, std::optional<std::chrono::milliseconds>);
+
+/// Same as calling change() for each id and notification, but queues all the changes with a single synchronization operation
+/// `ids` and `notifications` must have the same size. The notifications are moved out of the span.
+/// This is thread-safe and can be called from any thread
+void change_batch(std::span<NotificationId const> ids, std::span<Notification> notifications);
+
+/// Same as calling close_after_small_delay() for each id, but queues all the closes with a single synchronization operation
+/// This is thread-safe and can be called from any thread
+void close_after_small_delay_batch(std::span<NotificationId const>, std::chrono::milliseconds delay = 1s);
+
+/// Same as calling close_immediately() for each id, but queues all the closes with a single synchronization operation
+/// This is thread-safe and can be called from any thread
+void close_immediately_batch(std::span<NotificationId const>);
+
 /// Must be called once per frame, during your normal imgui frame (before ImGui::Render())
 void render_windows();
 
+/// Returns the time at which render_windows() needs to be called again for the notifications to keep animating and expiring properly, or std::nullopt if nothing will change on its own.
+/// Use it if you only render on events, to know how long you can sleep. If it is not in the future, render the next frame as soon as possible.
+/// It is computed by render_windows(), so call it after render_windows(). The time is in the same clock as the time source (see set_time_source()).
+/// NB: it can't know about what happens after render_windows(): you still need to render a frame when you send / change / close a notification, update a Progress, or when the content of a custom_imgui_content changes.
+auto next_required_frame_time() -> std::optional<std::chrono::steady_clock::time_point>;
+
+/// Sets the function used to get the current time, which drives all the animations and durations of the notifications.
+/// It is called only once per frame, at the beginning of render_windows(). Pass an empty function to go back to the default, steady_clock_time_source().
+void set_time_source(std::function<std::chrono::steady_clock::time_point()>);
+
+/// Real time. This is the default time source.
+auto steady_clock_time_source() -> std::function<std::chrono::steady_clock::time_point()>;
+
+/// Time that advances by ImGui::GetIO().DeltaTime every ImGui frame.
+/// Useful if you control the DeltaTime yourself, e.g. to export a video at a fixed framerate.
+auto imgui_time_source() -> std::function<std::chrono::steady_clock::time_point()>;
+
+/// Time that only moves when you tell it to. Mostly useful in tests.
+/// Since the time source references this object, it must outlive its use by ImGuiNotify.
+class ManualTimeSource {
+public:
+    void advance(std::chrono::steady_clock::duration duration) { _now += duration; }
+    void set(std::chrono::steady_clock::time_point now) { _now = now; }
+    auto now() const -> std::chrono::steady_clock::time_point { return _now; }
+
+    auto time_source() -> std::function<std::chrono::steady_clock::time_point()>;
+
+private:
+    std::chrono::steady_clock::time_point _now{};
+};
+
+struct AllocationStats {
+    size_t count{0}; // Number of heap allocations
+    size_t bytes{0}; // Total size requested by these allocations
+};
+
+/// Heap allocations (through operator new) made during the last call to render_windows()
+/// Only available if ImGuiNotify is built with the CMake option IMGUI_NOTIFY_ALLOCATION_TRACKING, because it replaces the global operator new to count allocations. Otherwise this always returns zeros.
+auto last_frame_allocation_stats() -> AllocationStats;
+
+/// Heap allocations (through operator new) made by the calling thread since it started
+/// Only available if ImGuiNotify is built with the CMake option IMGUI_NOTIFY_ALLOCATION_TRACKING. Otherwise this always returns zeros.
+auto thread_allocation_stats() -> AllocationStats;
+
 /// Must be called once when initializing imgui (if you use a custom font, call it just after adding that font)
 /// If you don't use custom fonts, you must call ImGui::GetIO().Fonts->AddFontDefault() before calling ImGuiNotify::add_icons_to_current_font()
 /// NB: you might have to tweak glyph_offset if the icons don't properly align with your custom font
@@ -86,11 +234,13 @@ struct Style {
     float                     padding_x{20.f}; // Padding from the right of the window
     float                     padding_y{20.f}; // Padding from the bottom of the window
     float                     padding_between_notifications_y{10.f};
-    float                     min_width{325.f};         // Forces notifications to have at least this width
-    float                     border_width{5.f};        // Size of the border around the notifications
-    std::chrono::milliseconds fade_in_duration{200ms};  // Duration of the transition when a notification appears
-    std::chrono::milliseconds fade_out_duration{200ms}; // Duration of the transition when a notification disappears
-    std::chrono::milliseconds change_duration{200ms};   // Duration of the transition when a notification changes (with ImGuiNotify::Change())
+    float                     min_width{325.f};           // Forces notifications to have at least this width
+    float                     border_width{5.f};          // Size of the border around the notifications
+    bool                      single_window{false};       // Render all the notifications inside a single window instead of one window per notification. This is cheaper when there are many notifications, and adds a scrollbar when they don't fit on screen. Notifications are then stacked by priority, the most important ones at the bottom, which is visible by default.
+    bool                      reuse_static_layouts{true}; // Notifications that are not animating reuse the sizes measured and the vertices generated during a previous frame, instead of laying out and drawing their content again every frame. Notifications with a custom_imgui_content are always rendered from scratch, because they could change at any time.
+    std::chrono::milliseconds fade_in_duration{200ms};    // Duration of the transition when a notification appears
+    std::chrono::milliseconds fade_out_duration{200ms};   // Duration of the transition when a notification disappears
+    std::chrono::milliseconds change_duration{200ms};     // Duration of the transition when a notification changes (with ImGuiNotify::Change())
 };
 
 inline auto get_style() -> Style&
@@ -100,3 +250,11 @@ inline auto get_style() -> Style&
 }
 
 } // namespace ImGuiNotify
+
+template<>
+struct std::hash<ImGuiNotify::NotificationId> {
+    auto operator()(ImGuiNotify::NotificationId const& id) const noexcept -> size_t
+    {
+        return std::hash<uint64_t>{}(id._id);
+    }
+};
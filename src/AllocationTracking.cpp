@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include <new>
+#include "ImGuiNotify/ImGuiNotify.hpp"
+
+namespace ImGuiNotify {
+
+#if IMGUI_NOTIFY_ALLOCATION_TRACKING
+
+static thread_local AllocationStats thread_stats{}; // NOLINT(*avoid-non-const-global-variables)
+
+auto thread_allocation_stats() -> AllocationStats
+{
+    return thread_stats;
+}
+
+} // namespace ImGuiNotify
+
+auto operator new(size_t size) -> void*
+{
+    ImGuiNotify::thread_stats.count++;
+    ImGuiNotify::thread_stats.bytes += size;
+    if (void* const ptr = std::malloc(size == 0 ? 1 : size)) // NOLINT(*owning-memory, *no-malloc)
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr); // NOLINT(*owning-memory, *no-malloc)
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr); // NOLINT(*owning-memory, *no-malloc)
+}
+
+#else
+
+auto thread_allocation_stats() -> AllocationStats
+{
+    return {};
+}
+
+} // namespace ImGuiNotify
+
+#endif
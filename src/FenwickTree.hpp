@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace ImGuiNotify {
+
+/// Sequence of non-negative values, whose prefix sums can be queried in O(log N) even though any value can be changed in O(log N).
+/// Sums are accumulated in double precision, so that the rounding errors of many successive changes stay negligible.
+class FenwickTree {
+public:
+    /// Keeps the memory, so that rebuilding the tree doesn't allocate
+    void clear()
+    {
+        _values.clear();
+        _tree.clear();
+        _tree.push_back(0.); // The tree is 1-based
+    }
+
+    /// O(log N)
+    void push_back(float value)
+    {
+        _values.push_back(value);
+        size_t const index = _values.size();
+        // The node covers the values in ]index - lowest_bit(index), index]
+        _tree.push_back(static_cast<double>(value) + prefix_sum_impl(index - 1) - prefix_sum_impl(index - lowest_bit(index)));
+    }
+
+    /// O(log N)
+    void set(size_t index, float value)
+    {
+        double const delta = static_cast<double>(value) - static_cast<double>(_values[index]);
+        _values[index]     = value;
+        for (size_t i = index + 1; i < _tree.size(); i += lowest_bit(i))
+            _tree[i] += delta;
+    }
+
+    auto value(size_t index) const -> float { return _values[index]; }
+    auto size() const -> size_t { return _values.size(); }
+
+    /// Sum of the first `count` values, in O(log N)
+    auto prefix_sum(size_t count) const -> float { return static_cast<float>(prefix_sum_impl(count)); }
+    auto total() const -> float { return prefix_sum(size()); }
+
+    /// Returns the biggest `count` such that prefix_sum(count) <= `sum`, in O(log N)
+    auto count_up_to(float sum) const -> size_t
+    {
+        size_t count     = 0;
+        double remaining = static_cast<double>(sum);
+        for (size_t step = highest_bit(size()); step != 0; step /= 2)
+        {
+            if (count + step < _tree.size() && _tree[count + step] <= remaining)
+            {
+                count += step;
+                remaining -= _tree[count];
+            }
+        }
+        return count;
+    }
+
+private:
+    auto prefix_sum_impl(size_t count) const -> double
+    {
+        double sum = 0.;
+        for (size_t i = count; i != 0; i -= lowest_bit(i))
+            sum += _tree[i];
+        return sum;
+    }
+
+    static auto lowest_bit(size_t i) -> size_t { return i & (~i + 1); }
+    static auto highest_bit(size_t i) -> size_t
+    {
+        size_t bit = 1;
+        while (bit * 2 <= i)
+            bit *= 2;
+        return i == 0 ? 0 : bit;
+    }
+
+private:
+    std::vector<float>  _values{};
+    std::vector<double> _tree{0.}; // _tree[i] is the sum of the values in ]i - lowest_bit(i), i]
+};
+
+} // namespace ImGuiNotify
@@ -2,21 +2,276 @@
 #include <imgui.h>
 //
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
+#include "FenwickTree.hpp"
 #include "IconsFontAwesome6.h"
 #include "ImGuiNotify/ImGuiNotify.hpp"
+#include "MpscQueue.hpp"
+#include "SlotMap.hpp"
+#include "TimerWheel.hpp"
+#include "TokenBucket.hpp"
 #include "fa-solid-900.h"
 #include "imgui_internal.h"
 
 namespace ImGuiNotify {
 
+auto NotificationId::generate_id() -> uint64_t
+{
+    // Each thread reserves a block of ids at once, so that threads sending lots of notifications don't all contend on the same atomic counter
+    static constexpr uint64_t block_size{256};
+    static auto               next_block_start = std::atomic<uint64_t>{1}; // 0 is an invalid ID, start at 1
+
+    thread_local uint64_t next_id{0};
+    thread_local uint64_t block_end{0};
+    if (next_id == block_end)
+    {
+        next_id   = next_block_start.fetch_add(block_size, std::memory_order_relaxed);
+        block_end = next_id + block_size;
+    }
+    return next_id++;
+}
+
+auto generate_notification_id() -> NotificationId
+{
+    return NotificationId{NotificationId::MakeValid{}};
+}
+
+using TimePoint = std::chrono::steady_clock::time_point;
+
+static auto default_priority(Type type) -> int
+{
+    switch (type)
+    {
+    case Type::Info:
+        return 0;
+    case Type::Success:
+        return 1;
+    case Type::Warning:
+        return 2;
+    case Type::Error:
+        return 3;
+    default:
+        assert(false);
+        return 0;
+    }
+}
+
+static auto priority(Notification const& notification) -> int
+{
+    return notification.priority.value_or(default_priority(notification.type));
+}
+
+static auto deduplication_hash(Notification const& notification) -> size_t
+{
+    if (!notification.deduplication_key.empty())
+        return std::hash<std::string_view>{}(notification.deduplication_key);
+
+    auto hash          = std::hash<int>{}(static_cast<int>(notification.type));
+    auto const combine = [&](std::string const& str) {
+        hash ^= std::hash<std::string_view>{}(str) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(notification.title);
+    combine(notification.content);
+    return hash;
+}
+
+static auto are_duplicates(Notification const& a, Notification const& b) -> bool
+{
+    if (!a.deduplicate || !b.deduplicate)
+        return false;
+    if (!a.deduplication_key.empty() || !b.deduplication_key.empty())
+        return a.deduplication_key == b.deduplication_key;
+    return a.type == b.type
+           && a.title == b.title
+           && a.content == b.content;
+}
+
+static auto time_source() -> std::function<TimePoint()>&
+{
+    static auto instance = std::function<TimePoint()>{};
+    return instance;
+}
+
+void set_time_source(std::function<TimePoint()> time_source)
+{
+    ImGuiNotify::time_source() = std::move(time_source);
+}
+
+/// Only called once per frame, at the beginning of render_windows(). Everything else uses that frame time.
+static auto now() -> TimePoint
+{
+    if (time_source())
+        return time_source()();
+    return std::chrono::steady_clock::now();
+}
+
+auto steady_clock_time_source() -> std::function<TimePoint()>
+{
+    return []() { return std::chrono::steady_clock::now(); };
+}
+
+auto imgui_time_source() -> std::function<TimePoint()>
+{
+    return [time = TimePoint{}, last_frame = -1]() mutable {
+        // Only accumulate once per ImGui frame, even if we get called several times during that frame
+        if (ImGui::GetFrameCount() != last_frame)
+        {
+            last_frame = ImGui::GetFrameCount();
+            time += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>{ImGui::GetIO().DeltaTime});
+        }
+        return time;
+    };
+}
+
+auto ManualTimeSource::time_source() -> std::function<TimePoint()>
+{
+    return [this]() { return _now; };
+}
+
+// Schedules the removal of the notifications, so that render_windows() only needs to look at the notifications that have expired, instead of checking all of them every frame
+static auto expiry_timers() -> TimerWheel<NotificationId>&
+{
+    static auto instance = TimerWheel<NotificationId>{};
+    return instance;
+}
+
+/// Everything that the size of a notification depends on, apart from the notification itself
+struct LayoutKey {
+    float   width;
+    ImFont* font;
+    float   font_size;
+    ImVec2  window_padding;
+    ImVec2  item_spacing;
+    ImVec2  frame_padding;
+
+    friend auto operator==(LayoutKey const& a, LayoutKey const& b) -> bool
+    {
+        return a.width == b.width
+               && a.font == b.font
+               && a.font_size == b.font_size
+               && a.window_padding.x == b.window_padding.x && a.window_padding.y == b.window_padding.y
+               && a.item_spacing.x == b.item_spacing.x && a.item_spacing.y == b.item_spacing.y
+               && a.frame_padding.x == b.frame_padding.x && a.frame_padding.y == b.frame_padding.y;
+    }
+};
+
+static auto current_layout_key(float width) -> LayoutKey
+{
+    ImGuiStyle const& style = ImGui::GetStyle();
+    return {
+        .width          = width,
+        .font           = ImGui::GetFont(),
+        .font_size      = ImGui::GetFontSize(),
+        .window_padding = style.WindowPadding,
+        .item_spacing   = style.ItemSpacing,
+        .frame_padding  = style.FramePadding,
+    };
+}
+
+/// Sizes measured while rendering a notification, that can be reused as long as neither the notification nor its LayoutKey change
+struct Layout {
+    LayoutKey key;
+    float     title_bar_height;
+    float     full_height; // Height of the whole notification, without any transition
+};
+
+/// Everything that the geometry of a notification depends on, apart from the notification itself
+struct GeometryKey {
+    LayoutKey   layout;
+    ImU32       icon_color;
+    ImU32       title_background_color;
+    ImU32       text_color;
+    ImU32       text_disabled_color;
+    ImTextureID texture;
+    ImVec2      white_pixel_uv; // Changes when the font atlas is rebuilt
+
+    friend auto operator==(GeometryKey const& a, GeometryKey const& b) -> bool
+    {
+        return a.layout == b.layout
+               && a.icon_color == b.icon_color
+               && a.title_background_color == b.title_background_color
+               && a.text_color == b.text_color
+               && a.text_disabled_color == b.text_disabled_color
+               && a.texture == b.texture
+               && a.white_pixel_uv.x == b.white_pixel_uv.x && a.white_pixel_uv.y == b.white_pixel_uv.y;
+    }
+};
+
+/// Vertices and indices generated while rendering a notification (apart from its close button, which must stay interactive), that can be replayed at another position as long as neither the notification nor its GeometryKey change
+struct Geometry {
+    GeometryKey             key;
+    ImVec2                  content_size; // Space taken by the widgets that generated the geometry
+    std::vector<ImDrawVert> vertices;     // Relative to the top-left corner of the content
+    std::vector<ImDrawIdx>  indices;      // Relative to the first vertex
+};
+
+/// Everything that the wrapping of a text depends on
+struct TextLayoutKey {
+    size_t  text_hash;
+    float   wrap_width;
+    ImFont* font;
+    float   font_size;
+
+    friend auto operator==(TextLayoutKey const&, TextLayoutKey const&) -> bool = default;
+};
+
+/// Lines of a wrapped text, that are only computed again when the TextLayoutKey changes, because wrapping long texts (e.g. stack traces or compiler output) is expensive
+struct TextLayout {
+    struct Line {
+        uint32_t begin; // Offsets in the text, in bytes
+        uint32_t end;
+    };
+
+    std::optional<TextLayoutKey> key{};
+    ImVec2                       size{};
+    std::vector<Line>            lines{};
+};
+
+struct CardHeight {
+    float height{};  // Visible height of the card, taking its transitions into account
+    float spacing{}; // Space between this card and the next one
+};
+
+// Only used in single window mode, see CardStack
+struct CardState {
+    uint32_t                 index{0};            // Position of the card in the stack
+    bool                     needs_update{false}; // Whether the card is waiting in CardStack::_cards_to_update
+    std::optional<TimePoint> fade_out_time{};     // When the card has been scheduled to start fading out in CardStack::_fade_outs
+};
+
 class NotificationImpl {
 public:
-    explicit NotificationImpl(Notification notification)
+    NotificationImpl(Notification notification, NotificationId unique_id)
         : _notification{std::move(notification)}
-    {}
+        , _content_hash{std::hash<std::string>{}(_notification.content)}
+        , _unique_id{unique_id}
+        , _expiry_timer{unique_id}
+    {
+        // Computed once, so that rendering doesn't need to allocate a new string every frame
+        static constexpr auto prefix = std::string_view{"##notification"};
+        std::copy(prefix.begin(), prefix.end(), _window_name.begin());
+        *std::to_chars(_window_name.data() + prefix.size(), _window_name.data() + _window_name.size() - 1, _unique_id._id).ptr = '\0';
+    }
+    ~NotificationImpl() { expiry_timers().cancel(_expiry_timer); }
+    NotificationImpl(NotificationImpl const&)                = delete;
+    NotificationImpl& operator=(NotificationImpl const&)     = delete;
+    NotificationImpl(NotificationImpl&&) noexcept            = delete;
+    NotificationImpl& operator=(NotificationImpl&&) noexcept = delete;
 
     auto color() const -> ImVec4
     {
@@ -56,49 +311,61 @@ public:
 
     auto has_content() const -> bool
     {
-        return !_notification.content.empty() || _notification.custom_imgui_content;
+        return !_notification.content.empty() || _notification.custom_imgui_content || _notification.progress;
     }
     auto content() const -> std::string const& { return _notification.content; }
+    auto content_hash() const -> size_t { return _content_hash; }
+    auto content_layout() -> TextLayout& { return _content_layout; }
     auto custom_imgui_content() const -> std::function<void()> const& { return _notification.custom_imgui_content; }
+    auto progress() const -> Progress const& { return _notification.progress; }
     auto title() const -> std::string const& { return _notification.title; }
     auto unique_id() const -> NotificationId const& { return _unique_id; }
+    auto window_name() const -> const char* { return _window_name.data(); }
+    auto window_height() const -> std::optional<float> { return _window_height; }
     auto is_closable() const -> bool { return _notification.is_closable; }
     auto has_been_init() const -> bool { return _creation_time.has_value(); }
-
-    auto elapsed_time() const
+    auto is_admitted() const -> bool { return _is_admitted; }
+    void set_admitted() { _is_admitted = true; }
+    auto card() -> CardState& { return _card; }
+    auto notification() const -> Notification const& { return _notification; }
+    auto occurrences_count() const -> uint32_t { return _occurrences_count; }
+    /// The ids of the most recent duplicates that have been merged into this notification (at most max_aliases of them, so that memory doesn't grow when a notification is spammed)
+    auto aliases() const -> std::span<NotificationId const> { return std::span{_aliases}.first(std::min<size_t>(_occurrences_count - 1, max_aliases)); }
+
+    auto elapsed_time(TimePoint now) const
     {
         assert(has_been_init());
-        return std::chrono::steady_clock::now() - *_creation_time;
+        return now - *_creation_time;
     }
 
-    auto duration_before_fade_out_starts() const
+    auto duration_before_fade_out_starts(TimePoint now) const
     {
         assert(has_been_init());
         assert(_notification.duration.has_value());
-        return *_notification.duration + get_style().fade_in_duration - elapsed_time();
+        return *_notification.duration + get_style().fade_in_duration - elapsed_time(now);
     }
 
-    auto has_expired() const -> bool
+    auto has_expired(TimePoint now) const -> bool
     {
         return _remove_asap
                || (has_been_init()
                    && _notification.duration.has_value()
-                   && elapsed_time() > *_notification.duration + get_style().fade_in_duration + get_style().fade_out_duration);
+                   && elapsed_time(now) > *_notification.duration + get_style().fade_in_duration + get_style().fade_out_duration);
     }
 
-    auto is_fading_out() const -> bool
+    auto is_fading_out(TimePoint now) const -> bool
     {
         return has_been_init()
                && _notification.duration.has_value()
-               && elapsed_time() > *_notification.duration + get_style().fade_in_duration;
+               && elapsed_time(now) > *_notification.duration + get_style().fade_in_duration;
     }
 
-    auto fade_percent() const -> float
+    auto fade_percent(TimePoint now) const -> float
     {
         if (!has_been_init())
             return 0.f;
 
-        float const elapsed_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_time()).count());
+        float const elapsed_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_time(now)).count());
         float const fade_in_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(get_style().fade_in_duration).count());
 
         float percent = 1.f;
@@ -116,33 +383,87 @@ public:
         return std::clamp(percent, 0.f, 1.f);
     }
 
-    void init_creation_time_ifn()
+    /// True when the notification is not animating, and its size only depends on its content, so that it can reuse the layout measured during a previous frame
+    auto can_reuse_layout(TimePoint now) const -> bool
+    {
+        return get_style().reuse_static_layouts
+               && has_been_init()
+               && !_notification.custom_imgui_content // Its size could change at any time
+               && next_change_time(now) != now;
+    }
+
+    /// Returns nullptr if no layout has been measured since the notification last changed, or if it was measured with a different `key`
+    auto cached_layout(LayoutKey const& key) const -> Layout const*
+    {
+        return _layout.has_value() && _layout->key == key ? &*_layout : nullptr;
+    }
+    void set_cached_layout(Layout const& layout) { _layout = layout; }
+
+    /// Returns nullptr if no geometry has been recorded since the notification last changed, or if it was recorded with a different `key`
+    auto cached_geometry(GeometryKey const& key) const -> Geometry const*
+    {
+        return _geometry.has_value() && _geometry->key == key ? &*_geometry : nullptr;
+    }
+    void set_cached_geometry(Geometry geometry) { _geometry = std::move(geometry); }
+
+    /// Returns `now` while the notification is animating, otherwise the time at which it will start animating (i.e. fading out), or std::nullopt if it won't change on its own
+    auto next_change_time(TimePoint now) const -> std::optional<TimePoint>
+    {
+        if (_remove_asap)
+            return now;
+        if (!has_been_init())
+            return std::nullopt; // Will start animating once it gets shown
+        if (elapsed_time(now) < get_style().fade_in_duration || _time_of_change.has_value()) // _time_of_change is reset once the change transition is over
+            return now;
+        if (!_notification.duration.has_value())
+            return std::nullopt;
+        return std::max(now, *_creation_time + get_style().fade_in_duration + *_notification.duration);
+    }
+
+    void init_creation_time_ifn(TimePoint now)
     {
         if (_creation_time.has_value())
             return;
-        _creation_time = std::chrono::steady_clock::now();
+        _creation_time = now;
+        update_expiry_timer();
     }
 
-    void reset_creation_time()
+    void reset_creation_time(TimePoint now)
     {
         if (!has_been_init())
             return;
-        if (elapsed_time() > get_style().fade_in_duration)
-            _creation_time = std::chrono::steady_clock::now() - get_style().fade_in_duration;
+        if (elapsed_time(now) > get_style().fade_in_duration)
+        {
+            _creation_time = now - get_style().fade_in_duration;
+            update_expiry_timer(); // O(1), so it's fine to do it every frame while the notification is hovered
+        }
     }
 
-    void set_hovered(bool is_hovered)
+    void set_hovered(bool is_hovered, TimePoint now)
     {
         if (is_hovered && _notification.hovering_keeps_notification_alive)
-            reset_creation_time();
+            reset_creation_time(now);
     }
 
     void set_window_height(float height)
     {
-        _window_height = height;
+        _window_height                  = height;
+        _has_been_measured_since_change = true;
+    }
+
+    auto has_been_off_screen() const -> bool { return _has_been_off_screen; }
+    void set_has_been_off_screen() { _has_been_off_screen = true; }
+
+    /// For notifications that appear already fully visible, e.g. because the user scrolled to them
+    void init_creation_time_without_fade_in(TimePoint now)
+    {
+        if (_creation_time.has_value())
+            return;
+        _creation_time = now - get_style().fade_in_duration;
+        update_expiry_timer();
     }
 
-    void close_after_at_most(std::chrono::milliseconds delay)
+    void close_after_at_most(std::chrono::milliseconds delay, TimePoint now)
     {
         if (!has_been_init())
         {
@@ -152,41 +473,131 @@ public:
             else
                 _notification.duration = delay;
         }
-        else if (!_notification.duration.has_value() || duration_before_fade_out_starts() > delay)
+        else if (!_notification.duration.has_value() || duration_before_fade_out_starts(now) > delay)
         {
             // Adapt the duration so that the fade out starts in exactly `delay`
             _notification.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                elapsed_time() - get_style().fade_in_duration + delay
+                elapsed_time(now) - get_style().fade_in_duration + delay
             );
         }
+        update_expiry_timer();
     }
 
-    void close_immediately()
+    void close_immediately(TimePoint now)
     {
         _notification.hovering_keeps_notification_alive = false;
         if (!has_been_init())
+        {
             _remove_asap = true; // If we close immediately after sending, this prevents the notification from animating in, and then animating out immediately. This cancels all the animations.
+            expiry_timers().schedule(_expiry_timer, now);
+        }
         else
-            close_after_at_most(0ms);
+        {
+            close_after_at_most(0ms, now);
+        }
     }
 
-    void change(Notification notification)
+    void change(Notification notification, TimePoint now)
     {
         _notification = std::move(notification);
-        reset_creation_time();
-        if (_window_height.has_value())
+        _content_hash = std::hash<std::string>{}(_notification.content);
+        invalidate_layout();
+        reset_creation_time(now);
+        update_expiry_timer(); // The duration might have changed
+        start_window_height_transition(now);
+    }
+
+    void set_title(std::string title, TimePoint now)
+    {
+        if (title == _notification.title)
+            return;
+        _notification.title = std::move(title);
+        invalidate_layout();
+        reset_creation_time(now);
+        start_window_height_transition(now);
+    }
+
+    void set_content(std::string content, TimePoint now)
+    {
+        if (content == _notification.content)
+            return;
+        _notification.content = std::move(content);
+        _content_hash         = std::hash<std::string>{}(_notification.content);
+        invalidate_layout();
+        reset_creation_time(now);
+        start_window_height_transition(now);
+    }
+
+    void set_type(Type type, TimePoint now)
+    {
+        if (type == _notification.type)
+            return;
+        _notification.type = type;
+        invalidate_layout();      // The icon changes
+        reset_creation_time(now); // Only the color and icon change, which doesn't change the layout, so no need for a transition
+    }
+
+    void set_duration(std::optional<std::chrono::milliseconds> duration)
+    {
+        _notification.duration = duration;
+        update_expiry_timer();
+    }
+
+    /// Must be called whenever something that has_expired() depends on changes
+    void update_expiry_timer()
+    {
+        if (_remove_asap)
+            return; // Already scheduled for now
+        if (!has_been_init() || !_notification.duration.has_value())
         {
-            _window_height_before_change = *_window_height;
-            _time_of_change              = std::chrono::steady_clock::now();
+            expiry_timers().cancel(_expiry_timer);
+            return;
         }
+        expiry_timers().schedule(_expiry_timer, *_creation_time + *_notification.duration + get_style().fade_in_duration + get_style().fade_out_duration);
+    }
+
+    void start_window_height_transition(TimePoint now)
+    {
+        if (!_window_height.has_value())
+            return;
+        _window_height_before_change    = *_window_height;
+        _time_of_change                 = now;
+        _has_been_measured_since_change = false;
+    }
+
+    /// Merges a duplicate of this notification into it
+    /// Returns the alias that has been forgotten to make room for the new one, if any
+    auto add_occurrence(NotificationId alias, TimePoint now) -> std::optional<NotificationId>
+    {
+        auto  forgotten_alias = std::optional<NotificationId>{};
+        auto& slot            = _aliases[(_occurrences_count - 1) % max_aliases]; // Ring buffer: overwrites the oldest alias once it is full
+        if (_occurrences_count > max_aliases)
+            forgotten_alias = slot;
+        slot = alias;
+        ++_occurrences_count;
+        invalidate_layout(); // The number of occurrences is displayed in the title bar
+        reset_creation_time(now);
+        return forgotten_alias;
+    }
+
+    void invalidate_layout()
+    {
+        _layout.reset();
+        _geometry.reset();
+        _content_layout.key.reset(); // Its key already changes with the content, but this makes sure we never use the lines of another text, even if their hashes collide
     }
 
-    void apply_window_height_transition_ifn(float& window_height)
+    void apply_window_height_transition_ifn(float& window_height, TimePoint now)
     {
         if (!_time_of_change.has_value())
             return;
+        if (_has_been_measured_since_change && window_height == _window_height_before_change)
+        {
+            _time_of_change.reset(); // The new text takes as much room as the old one, so there is nothing to animate, and the layout can be reused again
+            return;
+        }
 
-        float const time_since_change_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - *_time_of_change).count());
+        float const time_since_change_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(now - *_time_of_change).count());
         float const duration_ms          = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(get_style().change_duration).count());
 
         if (time_since_change_ms > duration_ms)
@@ -200,255 +611,1789 @@ public:
     }
 
 private:
-    Notification                                         _notification;
-    std::optional<std::chrono::steady_clock::time_point> _creation_time{};
-    bool                                                 _remove_asap{false};
-
-    std::optional<float>                                 _window_height{};
-    float                                                _window_height_before_change{};
-    std::optional<std::chrono::steady_clock::time_point> _time_of_change{};
-
-    NotificationId _unique_id{NotificationId::MakeValid{}};
+    Notification             _notification;
+    size_t                   _content_hash;
+    TextLayout               _content_layout{};
+    std::optional<TimePoint> _creation_time{};
+    bool                     _remove_asap{false};
+    bool                     _is_admitted{false}; // False while the notification is waiting in pending_notifications()
+    CardState                _card{};
+
+    static constexpr size_t                 max_aliases{16};
+    uint32_t                                _occurrences_count{1};
+    std::array<NotificationId, max_aliases> _aliases{};
+
+    std::optional<float>     _window_height{};
+    float                    _window_height_before_change{};
+    std::optional<TimePoint> _time_of_change{};
+    bool                     _has_been_measured_since_change{false}; // Until then, the window height is the one of the old content
+    bool                     _has_been_off_screen{false};
+    std::optional<Layout>    _layout{};
+    std::optional<Geometry>  _geometry{};
+
+    NotificationId                   _unique_id;
+    TimerWheel<NotificationId>::Node _expiry_timer;
+    std::array<char, 40>             _window_name{}; // Big enough for "##notification" followed by any uint64_t
 };
 
+// Notifications never move in memory once created
+// Only the displayed ones are iterated over, in the order they have been admitted (see admit_next_pending_notification()), so that rendering doesn't have to skip the pending ones
 static auto notifications() -> auto&
 {
-    static auto instance = std::vector<NotificationImpl>{};
+    expiry_timers(); // Makes sure the timers are destroyed after the notifications, because notifications unregister from them when destroyed
+    static auto instance = SlotMap<NotificationImpl>{};
     return instance;
 }
-// We don't want to lock while rendering the notifications in render_windows()
-// because we want to allow the custom_imgui_content() of notifications to send / change / close notifications.
-// So instead we delay all these actions so that they don't conflict while we are iterating on the list of notifications
-static auto delayed_actions() -> auto&
+// Slot of each notification in notifications(), so that commands can find their notification in constant time
+static auto notification_index() -> auto&
 {
-    static auto instance = std::vector<std::function<void()>>{};
+    static auto instance = std::unordered_map<NotificationId, SlotHandle>{};
     return instance;
 }
-static auto delayed_actions_mutex() -> auto&
+// Slot of the alive notifications that have `deduplicate` set, indexed by their deduplication_hash(), so that finding a duplicate takes constant time
+static auto deduplication_index() -> auto&
 {
-    static auto instance = std::mutex{};
+    static auto instance = std::unordered_map<size_t, SlotHandle>{};
     return instance;
 }
 
-auto send(Notification notification) -> NotificationId
-{
-    auto       notif_impl = NotificationImpl{std::move(notification)};
-    auto const id         = notif_impl.unique_id();
+struct PendingNotification {
+    int        priority;
+    uint64_t   send_order; // Among notifications with the same priority, the oldest one is shown first
+    SlotHandle handle;
+
+    friend auto operator<(PendingNotification const& a, PendingNotification const& b) -> bool
     {
-        auto lock = std::unique_lock{delayed_actions_mutex()};
-        delayed_actions().emplace_back([notif_impl = std::move(notif_impl)]() {
-            notifications().emplace_back(notif_impl);
-        });
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+        return a.send_order > b.send_order;
     }
-    return id;
-}
+};
 
-static void with_notification(NotificationId id, std::function<void(NotificationImpl&)> const& callback)
-{
-    auto const it = std::find_if(notifications().begin(), notifications().end(), [&](NotificationImpl const& notification) {
-        return notification.unique_id() == id;
-    });
-    if (it == notifications().end())
-        return;
-    callback(*it);
-}
+// Notifications that have been sent but are not displayed yet, highest priority first
+// When the screen is full, this lets the most important ones pre-empt the others, without having to sort all the notifications every frame
+class PendingNotifications {
+public:
+    void push(int priority, SlotHandle handle)
+    {
+        _heap.push_back({priority, _next_send_order++, handle});
+        std::push_heap(_heap.begin(), _heap.end());
+    }
 
-void change(NotificationId id, Notification notification)
-{
-    auto lock = std::unique_lock{delayed_actions_mutex()};
+    /// Removes the most important pending notification that is still alive, and returns it
+    auto pop() -> std::optional<SlotHandle>;
 
-    delayed_actions().emplace_back([id, notification = std::move(notification)]() mutable {
-        with_notification(id, [&](NotificationImpl& notification_impl) {
-            notification_impl.change(std::move(notification));
-        });
-    });
-}
+    /// Must be called when a pending notification is erased from notifications(), after it has been erased
+    /// Its entry is only removed lazily, when it reaches the top of the heap, or when the erased entries outnumber the alive ones (which would otherwise happen when lots of notifications are closed before they could be displayed)
+    void on_erased();
 
-void close_after_small_delay(NotificationId id, std::chrono::milliseconds delay)
-{
-    auto lock = std::unique_lock{delayed_actions_mutex()};
+    /// Also contains the entries of the notifications that have been erased since they were sent
+    auto entries() const -> std::span<PendingNotification const> { return _heap; }
 
-    delayed_actions().emplace_back([id, delay]() {
-        with_notification(id, [&](NotificationImpl& notification) {
-            notification.close_after_at_most(delay);
-        });
-    });
-}
+private:
+    std::vector<PendingNotification> _heap{};
+    size_t                           _erased_count{0};
+    uint64_t                         _next_send_order{0};
+};
 
-void close_immediately(NotificationId id)
+auto PendingNotifications::pop() -> std::optional<SlotHandle>
 {
-    auto lock = std::unique_lock{delayed_actions_mutex()};
-
-    delayed_actions().emplace_back([id]() {
-        with_notification(id, [&](NotificationImpl& notification) {
-            notification.close_immediately();
-        });
-    });
+    while (!_heap.empty())
+    {
+        std::pop_heap(_heap.begin(), _heap.end());
+        SlotHandle const handle = _heap.back().handle;
+        _heap.pop_back();
+        if (notifications().get(handle) != nullptr)
+            return handle;
+        --_erased_count; // It has been closed or dropped while it was pending
+    }
+    return std::nullopt;
 }
 
-static auto ImU32_from_ImVec4(ImVec4 color) -> ImU32
+void PendingNotifications::on_erased()
 {
-    return ImGui::GetColorU32(IM_COL32(
-        color.x * 255.f,
-        color.y * 255.f,
-        color.z * 255.f,
-        color.w * 255.f
-    ));
+    ++_erased_count;
+    if (2 * _erased_count <= _heap.size())
+        return;
+    std::erase_if(_heap, [](PendingNotification const& pending) { return notifications().get(pending.handle) == nullptr; });
+    std::make_heap(_heap.begin(), _heap.end());
+    _erased_count = 0;
 }
 
-static auto background(ImVec4 color, std::function<void()> const& widget) -> ImRect
+static auto pending_notifications() -> PendingNotifications&
 {
-    ImDrawList& draw_list = *ImGui::GetWindowDrawList();
-    draw_list.ChannelsSplit(2);      // Allows us to draw the background rectangle behind the widget, even though the widget is drawn first.
-    draw_list.ChannelsSetCurrent(1); // We must draw them in that order because we need to know the height of the widget before drawing the rectangle.
-
-    ImVec2 const rectangle_start_pos = ImGui::GetCursorScreenPos() - ImGui::GetStyle().WindowPadding;
-
-    widget();
-
-    auto const rectangle_end_pos = ImVec2{
-        rectangle_start_pos.x + ImGui::GetContentRegionAvail().x + 2.f * ImGui::GetStyle().WindowPadding.x,
-        ImGui::GetCursorScreenPos().y
-    };
+    static auto instance = PendingNotifications{};
+    return instance;
+}
 
-    auto const rect = ImRect{rectangle_start_pos, rectangle_end_pos};
+// Only used in single window mode: the cards of the displayed notifications, from the bottom of the window (the first notification in notifications()) to its top
+// Their heights are cached, and prefix sums give the position of any card in O(log N), so that a frame only has to visit the cards that are animating or visible, instead of all of them
+// Only adding a card in the middle of the stack, or changing the style, requires visiting all the cards again (see mark_for_rebuild())
+class CardStack {
+public:
+    /// The whole stack will be rebuilt during the next update()
+    void mark_for_rebuild() { _needs_rebuild = true; }
+    /// Must be called when the notification has just been moved to the end of notifications()
+    void push_back(NotificationImpl&, SlotHandle);
+    /// Must be called before the notification is erased
+    /// Its card stays in the stack with an empty height until the next rebuild, so that the cards above it don't have to move
+    void erase(NotificationImpl&);
+    /// Must be called when something that the height of the card depends on might have changed, e.g. because a command has been applied to its notification
+    void mark_for_update(NotificationImpl&, SlotHandle);
+
+    /// Brings the heights of the cards that need it up to date, and requests the frames that the animations of the cards need
+    void update(TimePoint now);
+
+    auto size() const -> size_t { return _handles.size(); }
+    auto handle(size_t index) const -> SlotHandle { return _handles[index]; }
+    auto height(size_t index) const -> CardHeight { return _heights[index]; }
+    /// Distance between the bottom of the stack and the bottom of the card (i.e. of the spacing below it)
+    auto bottom(size_t index) const -> float { return _sums.prefix_sum(index); }
+    auto total_height() const -> float { return _sums.total(); }
+    /// Index of the lowest card whose top is above `y` (measured from the bottom of the stack), or size() if there is none
+    auto first_card_above(float y) const -> size_t { return _sums.count_up_to(y); }
 
-    draw_list.ChannelsSetCurrent(0);
-    draw_list.AddRectFilled(
-        rect.GetTL(),
-        rect.GetBR(),
-        ImU32_from_ImVec4(color)
-    );
-    draw_list.ChannelsMerge();
+private:
+    void rebuild(TimePoint now);
+    void update_card(NotificationImpl&, SlotHandle, TimePoint now);
+    void schedule_fade_out(NotificationImpl&, SlotHandle, std::optional<TimePoint> time);
 
-    return rect;
-}
+    struct FadeOut {
+        TimePoint  time;
+        SlotHandle handle;
 
-static auto close_button(ImRect const title_bar_rect) -> bool
-{
-    bool has_closed{false};
+        friend auto operator<(FadeOut const& a, FadeOut const& b) -> bool { return a.time > b.time; } // The earliest one is at the top of the heap
+    };
 
-    ImGuiContext&      g{*GImGui};
-    ImGuiWindow* const window{ImGui::GetCurrentWindow()};
-    // Close button is on the Menu NavLayer and doesn't default focus (unless there's nothing else on that layer)
-    // FIXME-NAV: Might want (or not?) to set the equivalent of ImGuiButtonFlags_NoNavFocus so that mouse clicks on standard title bar items don't necessarily set nav/keyboard ref?
-    ImGuiItemFlags const item_flags_backup = g.CurrentItemFlags;
-    g.CurrentItemFlags |= ImGuiItemFlags_NoNavDefaultFocus;
-    window->DC.NavLayerCurrent = ImGuiNavLayer_Menu;
+    // Everything the heights of all the cards depend on
+    struct StyleSnapshot {
+        float                     padding_between_notifications_y{};
+        std::chrono::milliseconds fade_in_duration{};
+        std::chrono::milliseconds fade_out_duration{};
+        std::chrono::milliseconds change_duration{};
 
-    float const button_sz        = ImGui::GetFontSize();
-    auto const  close_button_pos = ImVec2{
-        title_bar_rect.Max.x - button_sz - ImGui::GetStyle().FramePadding.x,
-        title_bar_rect.GetCenter().y - button_sz * 0.5f,
+        friend auto operator==(StyleSnapshot const&, StyleSnapshot const&) -> bool = default;
     };
 
-    if (ImGui::CloseButton(window->GetID("#CLOSE"), close_button_pos))
-        has_closed = true;
-
-    window->DC.NavLayerCurrent = ImGuiNavLayer_Main;
-    g.CurrentItemFlags         = item_flags_backup;
+private:
+    std::vector<SlotHandle> _handles{};
+    std::vector<CardHeight> _heights{};
+    FenwickTree             _sums{}; // height + spacing of each card
+    std::vector<SlotHandle> _cards_to_update{};
+    std::vector<SlotHandle> _cards_being_updated{}; // Swapped with _cards_to_update during update(), so that their memory is reused
+    std::vector<FadeOut>    _fade_outs{};           // When the cards that are not animating will start fading out, as a heap. Entries that don't match CardState::fade_out_time anymore are stale, and are skipped
+    StyleSnapshot           _style{};
+    size_t                  _erased_count{0};
+    bool                    _needs_rebuild{true};
+};
 
-    return has_closed;
+static auto card_stack() -> CardStack&
+{
+    static auto instance = CardStack{};
+    return instance;
 }
 
-void render_windows()
+/// Moves the most important pending notification to the end of the displayed ones
+/// In single window mode, it goes before the ones that have a lower priority instead, so that the most important notifications are at the bottom, where the window is scrolled to by default
+/// Returns nullptr if there is no pending notification
+static auto admit_next_pending_notification() -> NotificationImpl*
 {
+    auto const handle = pending_notifications().pop();
+    if (!handle)
+        return nullptr;
+    NotificationImpl* const notification = notifications().get(*handle);
+    notification->set_admitted();
+    if (!get_style().single_window)
     {
-        auto lock = std::unique_lock{delayed_actions_mutex()};
-        for (auto const& action : delayed_actions())
-            action();
-        delayed_actions().clear();
+        notifications().move_to_back(*handle); // Displayed notifications are stacked in the order they have been admitted
+        return notification;
     }
+    // Only walks over the displayed notifications that have a lower priority, so admitting a notification of the lowest priority is O(1)
+    int const notification_priority = priority(notification->notification());
+    auto      previous              = notifications().rbegin();
+    while (previous != notifications().rend() && priority(previous->notification()) < notification_priority)
+        ++previous;
+    bool const is_at_the_top = previous == notifications().rbegin();
+    notifications().move_after(*handle, previous != notifications().rend() ? std::make_optional(previous.handle()) : std::nullopt);
+    if (is_at_the_top)
+        card_stack().push_back(*notification, *handle);
+    else
+        card_stack().mark_for_rebuild();
+    return notification;
+}
 
-    std::erase_if(notifications(), [](NotificationImpl const& notification) {
-        return notification.has_expired();
-    });
+static void add_to_deduplication_index(NotificationImpl const& notification, SlotHandle handle, TimePoint now)
+{
+    if (!notification.notification().deduplicate)
+        return;
+    auto const [it, has_been_inserted] = deduplication_index().try_emplace(deduplication_hash(notification.notification()), handle);
+    if (has_been_inserted)
+        return;
+    NotificationImpl const* const current = notifications().get(it->second);
+    if (current == nullptr || current->has_expired(now))
+        it->second = handle; // The notification that was indexed will be erased at the end of this frame, so it can't be merged into anymore
+    // Otherwise, in the very unlikely case of a hash collision, the new notification just won't be deduplicated
+}
 
-    float height = 0.f;
-    for (size_t i = 0; i < notifications().size(); ++i)
-    {
-        ImVec2 const main_window_pos  = ImGui::GetMainViewport()->Pos;
-        ImVec2 const main_window_size = ImGui::GetMainViewport()->Size;
+static void remove_from_deduplication_index(NotificationImpl const& notification, SlotHandle handle)
+{
+    if (!notification.notification().deduplicate)
+        return;
+    auto const it = deduplication_index().find(deduplication_hash(notification.notification()));
+    if (it != deduplication_index().end() && it->second == handle)
+        deduplication_index().erase(it);
+}
 
-        if (height > main_window_size.y - 100.f)
-            break; // TODO(Notifications) Allow scrolling. eg switch to rendering just one window, with all notifications as child windows, and rely on imgui to do the scrollbar
+/// Returns the alive notification that `notification` is a duplicate of, if any
+static auto find_duplicate(Notification const& notification, TimePoint now) -> NotificationImpl*
+{
+    if (!notification.deduplicate)
+        return nullptr;
+    auto const it = deduplication_index().find(deduplication_hash(notification));
+    if (it == deduplication_index().end())
+        return nullptr;
+    NotificationImpl* const duplicate = notifications().get(it->second);
+    if (duplicate == nullptr || duplicate->has_expired(now) || !are_duplicates(duplicate->notification(), notification))
+        return nullptr;
+    return duplicate;
+}
 
-        auto& notif = notifications()[i];
-        notif.init_creation_time_ifn(); // Init creation time the first time a notification is shown, because if they are outside the window they might prevent it from showing for a while, and we don't want it to disappear immediately after appearing
+struct SendCommand {
+    Notification notification;
+};
+struct ChangeCommand {
+    Notification notification;
+};
+struct SetTitleCommand {
+    std::string title;
+};
+struct SetContentCommand {
+    std::string content;
+};
+struct SetTypeCommand {
+    Type type;
+};
+struct SetDurationCommand {
+    std::optional<std::chrono::milliseconds> duration;
+};
+struct CloseAfterSmallDelayCommand {
+    std::chrono::milliseconds delay;
+};
+struct CloseImmediatelyCommand {};
 
-        // Set window position and size
-        ImGui::SetNextWindowPos(
-            ImVec2{
-                main_window_pos.x + main_window_size.x - get_style().padding_x,
-                main_window_pos.y + main_window_size.y - get_style().padding_y - height
-            },
-            ImGuiCond_Always, ImVec2{1.f, 1.f}
-        );
+struct Command {
+    Command*       next{nullptr};
+    NotificationId id;
+    std::variant<SendCommand, ChangeCommand, SetTitleCommand, SetContentCommand, SetTypeCommand, SetDurationCommand, CloseAfterSmallDelayCommand, CloseImmediatelyCommand> payload;
+};
+
+// We don't want to lock while rendering the notifications in render_windows()
+// because we want to allow the custom_imgui_content() of notifications to send / change / close notifications.
+// So instead we queue all these actions and apply them at the beginning of the next render_windows(), so that they don't conflict while we are iterating on the list of notifications
+// The queue is lock-free so that threads sending notifications never wait on the render thread (nor on each other)
+static auto commands() -> auto&
+{
+    static auto instance = MpscQueue<Command>{};
+    return instance;
+}
+
+// Number of commands that have been pushed and not applied yet
+static auto pending_commands_count() -> std::atomic<size_t>&
+{
+    static auto instance = std::atomic<size_t>{0};
+    return instance;
+}
+
+// Lives outside of capacity() because it is read by all the threads that send notifications
+static auto max_pending_commands() -> std::atomic<size_t>&
+{
+    static auto instance = std::atomic<size_t>{SIZE_MAX};
+    return instance;
+}
+
+// Only used by the thread that calls render_windows()
+static auto capacity() -> Capacity&
+{
+    static auto instance = Capacity{};
+    return instance;
+}
+
+static auto new_command(NotificationId id, auto&& payload) -> Command*
+{
+    return new Command{.id = id, .payload = std::forward<decltype(payload)>(payload)}; // NOLINT(*owning-memory) Ownership is taken back in apply_commands()
+}
+
+/// Reserves the place for `count` commands, without exceeding `max_pending_commands`
+/// Returns how many commands we are allowed to push
+static auto reserve_pending_commands(size_t count, size_t max_pending_commands) -> size_t
+{
+    // Reserve our place first, so that concurrent senders can't exceed the limit
+    size_t const previous_count = pending_commands_count().fetch_add(count, std::memory_order_relaxed);
+    size_t const reserved_count = previous_count >= max_pending_commands
+                                      ? 0
+                                      : std::min(count, max_pending_commands - previous_count);
+    if (reserved_count < count)
+        pending_commands_count().fetch_sub(count - reserved_count, std::memory_order_relaxed);
+    return reserved_count;
+}
+
+/// Returns false, without pushing anything, if there are already `max_pending_commands` pending commands
+static auto push_command(NotificationId id, auto&& payload, size_t max_pending_commands = SIZE_MAX) -> bool
+{
+    if (reserve_pending_commands(1, max_pending_commands) == 0)
+        return false;
+    commands().push(new_command(id, std::forward<decltype(payload)>(payload)));
+    return true;
+}
+
+/// Commands that are pushed all at once with push_command_batch()
+class CommandBatch {
+public:
+    void add(Command* command)
+    {
+        command->next = _newest;
+        _newest       = command;
+        if (_oldest == nullptr)
+            _oldest = command;
+    }
+
+    /// The place of the commands must have been reserved with reserve_pending_commands()
+    void push()
+    {
+        if (_newest != nullptr)
+            commands().push_chain(_newest, _oldest);
+    }
+
+private:
+    Command* _newest{nullptr};
+    Command* _oldest{nullptr};
+};
+
+/// Pushes one command per id, with a single synchronization operation
+static void push_command_batch(std::span<NotificationId const> ids, auto&& make_payload)
+{
+    reserve_pending_commands(ids.size(), SIZE_MAX);
+    auto batch = CommandBatch{};
+    for (size_t i = 0; i < ids.size(); ++i)
+        batch.add(new_command(ids[i], make_payload(i)));
+    batch.push();
+}
+
+static auto type_rate_limiters() -> auto&
+{
+    static auto instance = std::array<TokenBucket, 4>{}; // One per Type
+    return instance;
+}
+
+struct SourceRateLimiters {
+    struct Hash {
+        using is_transparent = void; // Allows us to find a source from a std::string_view, without allocating a std::string
+        auto operator()(std::string_view source) const -> size_t { return std::hash<std::string_view>{}(source); }
+    };
+
+    std::unordered_map<std::string, std::unique_ptr<TokenBucket>, Hash, std::equal_to<>> buckets{};
+    std::shared_mutex                                                                  mutex{}; // Senders only need a shared lock, so they don't block each other
+};
+
+static auto source_rate_limiters() -> SourceRateLimiters&
+{
+    static auto instance = SourceRateLimiters{};
+    return instance;
+}
+
+// Number of notifications that have been dropped because of a rate limit or of the capacity, and not reported yet by report_dropped_notifications()
+static auto dropped_notifications_count() -> std::atomic<uint64_t>&
+{
+    static auto instance = std::atomic<uint64_t>{0};
+    return instance;
+}
+
+// Number of send() that have been rejected because there were too many pending commands, and not reported yet by report_dropped_notifications()
+// They are counted separately from dropped_notifications_count() because only the render thread can read the overflow policy, to know if they must be reported
+static auto rejected_sends_count() -> std::atomic<uint64_t>&
+{
+    static auto instance = std::atomic<uint64_t>{0};
+    return instance;
+}
+
+void set_rate_limit(Type type, std::optional<RateLimit> rate_limit)
+{
+    type_rate_limiters()[static_cast<size_t>(type)].configure(
+        rate_limit ? rate_limit->notifications_per_second : 0.f,
+        rate_limit ? rate_limit->burst : 0
+    );
+}
+
+void set_rate_limit(std::string_view source, std::optional<RateLimit> rate_limit)
+{
+    auto& limiters = source_rate_limiters();
+    auto  lock     = std::unique_lock{limiters.mutex};
+    if (!rate_limit.has_value())
+    {
+        if (auto const it = limiters.buckets.find(source); it != limiters.buckets.end())
+            limiters.buckets.erase(it);
+        return;
+    }
+    auto it = limiters.buckets.find(source);
+    if (it == limiters.buckets.end())
+        it = limiters.buckets.emplace(std::string{source}, std::make_unique<TokenBucket>()).first;
+    it->second->configure(rate_limit->notifications_per_second, rate_limit->burst);
+}
+
+/// Rate limits are evaluated with the real time, because they are checked on the thread that sends the notification, not during render_windows()
+static auto is_rate_limited(Notification const& notification) -> bool
+{
+    auto const   time        = TokenBucket::Clock::now();
+    TokenBucket& type_bucket = type_rate_limiters()[static_cast<size_t>(notification.type)];
+    if (!type_bucket.try_acquire(time))
+        return true;
+    if (notification.source.empty())
+        return false;
+
+    auto& limiters = source_rate_limiters();
+    auto  lock     = std::shared_lock{limiters.mutex};
+    auto  it       = limiters.buckets.find(std::string_view{notification.source});
+    if (it == limiters.buckets.end() || it->second->try_acquire(time))
+        return false;
+    type_bucket.release(); // The notification is dropped, so it must not count towards the limit of its type
+    return true;
+}
+
+auto send(Notification notification) -> NotificationId
+{
+    if (is_rate_limited(notification))
+    {
+        dropped_notifications_count().fetch_add(1, std::memory_order_relaxed);
+        return NotificationId{};
+    }
+    auto const id = generate_notification_id();
+    if (!push_command(id, SendCommand{std::move(notification)}, max_pending_commands().load(std::memory_order_relaxed)))
+    {
+        rejected_sends_count().fetch_add(1, std::memory_order_relaxed);
+        return NotificationId{};
+    }
+    return id;
+}
+
+auto send_batch(std::span<Notification> notifications) -> std::vector<NotificationId>
+{
+    auto ids = std::vector<NotificationId>(notifications.size()); // Invalid ids for the notifications that get dropped
+
+    // Check the rate limits first, so that we only reserve the place of the notifications we will actually send
+    size_t accepted_count = 0;
+    for (size_t i = 0; i < notifications.size(); ++i)
+    {
+        if (is_rate_limited(notifications[i]))
+        {
+            dropped_notifications_count().fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ids[i] = generate_notification_id();
+        ++accepted_count;
+    }
+
+    size_t const reserved_count = reserve_pending_commands(accepted_count, max_pending_commands().load(std::memory_order_relaxed));
+    if (reserved_count < accepted_count)
+        rejected_sends_count().fetch_add(accepted_count - reserved_count, std::memory_order_relaxed);
+
+    auto   batch        = CommandBatch{};
+    size_t pushed_count = 0;
+    for (size_t i = 0; i < notifications.size(); ++i)
+    {
+        if (ids[i] == NotificationId{})
+            continue;
+        if (pushed_count == reserved_count)
+        {
+            ids[i] = NotificationId{}; // Rejected because there are too many pending commands
+            continue;
+        }
+        batch.add(new_command(ids[i], SendCommand{std::move(notifications[i])}));
+        ++pushed_count;
+    }
+    batch.push();
+    return ids;
+}
+
+void change_batch(std::span<NotificationId const> ids, std::span<Notification> notifications)
+{
+    assert(ids.size() == notifications.size());
+    push_command_batch(ids.first(std::min(ids.size(), notifications.size())), [&](size_t i) {
+        return ChangeCommand{std::move(notifications[i])};
+    });
+}
+
+void close_after_small_delay_batch(std::span<NotificationId const> ids, std::chrono::milliseconds delay)
+{
+    push_command_batch(ids, [&](size_t) {
+        return CloseAfterSmallDelayCommand{delay};
+    });
+}
+
+void close_immediately_batch(std::span<NotificationId const> ids)
+{
+    push_command_batch(ids, [&](size_t) {
+        return CloseImmediatelyCommand{};
+    });
+}
+
+void change(NotificationId id, Notification notification)
+{
+    push_command(id, ChangeCommand{std::move(notification)});
+}
+
+void set_title(NotificationId id, std::string title)
+{
+    push_command(id, SetTitleCommand{std::move(title)});
+}
+
+void set_content(NotificationId id, std::string content)
+{
+    push_command(id, SetContentCommand{std::move(content)});
+}
+
+void set_type(NotificationId id, Type type)
+{
+    push_command(id, SetTypeCommand{type});
+}
+
+void set_duration(NotificationId id, std::optional<std::chrono::milliseconds> duration)
+{
+    push_command(id, SetDurationCommand{duration});
+}
+
+void close_after_small_delay(NotificationId id, std::chrono::milliseconds delay)
+{
+    push_command(id, CloseAfterSmallDelayCommand{delay});
+}
+
+void close_immediately(NotificationId id)
+{
+    push_command(id, CloseImmediatelyCommand{});
+}
+
+void set_capacity(Capacity new_capacity)
+{
+    capacity() = new_capacity;
+    max_pending_commands().store(new_capacity.max_pending_commands, std::memory_order_relaxed);
+    if (new_capacity.max_notifications != SIZE_MAX)
+    {
+        size_t const max_notifications = new_capacity.max_notifications + 1; // The summary of the dropped notifications doesn't count towards the limit
+        notifications().reserve(max_notifications);
+        notification_index().reserve(max_notifications);
+        deduplication_index().reserve(max_notifications);
+    }
+}
+
+// Id of the notification that reports how many notifications have been dropped
+static auto dropped_notifications_summary_id() -> NotificationId&
+{
+    static auto instance = NotificationId{};
+    return instance;
+}
+
+static auto is_dropped_notifications_summary(NotificationImpl const& notification) -> bool
+{
+    return notification.unique_id() == dropped_notifications_summary_id();
+}
+
+/// The summary of the dropped notifications doesn't count towards the capacity
+static auto notifications_count_towards_capacity() -> size_t
+{
+    return notifications().size() - (notification_index().contains(dropped_notifications_summary_id()) ? 1 : 0);
+}
+
+static void erase_notification(SlotHandle handle)
+{
+    NotificationImpl* const notification = notifications().get(handle);
+    if (notification == nullptr)
+        return;
+    notification_index().erase(notification->unique_id());
+    for (auto const& alias : notification->aliases())
+        notification_index().erase(alias);
+    remove_from_deduplication_index(*notification, handle);
+    card_stack().erase(*notification);
+    bool const was_pending = !notification->is_admitted();
+    notifications().erase(handle);
+    if (was_pending)
+        pending_notifications().on_erased();
+}
+
+
+/// Returns the oldest notification that can be dropped to make room for new ones, if any
+/// Displayed notifications are dropped before the pending ones, which are sent after most of them
+static auto oldest_droppable_notification() -> std::optional<SlotHandle>
+{
+    for (auto it = notifications().begin(); it != notifications().end(); ++it)
+    {
+        if (!is_dropped_notifications_summary(*it))
+            return it.handle();
+    }
+    PendingNotification const* oldest = nullptr;
+    for (auto const& pending : pending_notifications().entries())
+    {
+        NotificationImpl const* const notification = notifications().get(pending.handle);
+        if (notification != nullptr && !is_dropped_notifications_summary(*notification) && (oldest == nullptr || pending.send_order < oldest->send_order))
+            oldest = &pending;
+    }
+    return oldest != nullptr ? std::make_optional(oldest->handle) : std::nullopt;
+}
+
+/// Removes a notification to make room for `new_notification`, according to the overflow policy
+/// Returns false if `new_notification` must be dropped instead
+static auto make_room_for(Notification const& new_notification) -> bool
+{
+    switch (capacity().overflow_policy)
+    {
+    case OverflowPolicy::DropOldest:
+    {
+        auto const oldest = oldest_droppable_notification();
+        if (!oldest)
+            return false;
+        erase_notification(*oldest);
+        return true;
+    }
+    case OverflowPolicy::DropLowestPriority:
+    {
+        auto const oldest = oldest_droppable_notification();
+        if (!oldest)
+            return false;
+        // Only happens when we are at full capacity, so it's fine to not have a dedicated data structure
+        SlotHandle least_important          = *oldest;
+        int        least_important_priority = priority(notifications().get(*oldest)->notification());
+        for (auto it = notifications().begin(); it != notifications().end(); ++it)
+        {
+            if (!is_dropped_notifications_summary(*it) && priority(it->notification()) < least_important_priority)
+            {
+                least_important          = it.handle();
+                least_important_priority = priority(it->notification());
+            }
+        }
+        for (auto const& pending : pending_notifications().entries())
+        {
+            NotificationImpl const* const notification = notifications().get(pending.handle);
+            if (notification != nullptr && !is_dropped_notifications_summary(*notification) && pending.priority < least_important_priority)
+            {
+                least_important          = pending.handle;
+                least_important_priority = pending.priority;
+            }
+        }
+        if (priority(new_notification) < least_important_priority)
+            return false;
+        erase_notification(least_important);
+        return true;
+    }
+    case OverflowPolicy::RejectNew:
+    {
+        return false;
+    }
+    case OverflowPolicy::MergeIntoSummary:
+    {
+        dropped_notifications_count().fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+static void with_notification(NotificationId id, auto&& callback)
+{
+    auto const it = notification_index().find(id);
+    if (it == notification_index().end())
+        return;
+    NotificationImpl* const notification = notifications().get(it->second);
+    if (notification == nullptr)
+        return;
+    callback(*notification, it->second);
+    card_stack().mark_for_update(*notification, it->second);
+}
+
+static void apply(NotificationId id, SendCommand& command, TimePoint frame_time)
+{
+    if (NotificationImpl* const duplicate = find_duplicate(command.notification, frame_time))
+    {
+        if (auto const forgotten_alias = duplicate->add_occurrence(id, frame_time))
+            notification_index().erase(*forgotten_alias);
+        SlotHandle const handle = notification_index().at(duplicate->unique_id());
+        notification_index().emplace(id, handle);
+        card_stack().mark_for_update(*duplicate, handle); // Its title bar changed
+        return;
+    }
+    if (id != dropped_notifications_summary_id()) // The summary must always be able to show up
+    {
+        while (notifications_count_towards_capacity() >= capacity().max_notifications)
+        {
+            if (!make_room_for(command.notification))
+                return;
+        }
+    }
+    int const        notification_priority = priority(command.notification);
+    SlotHandle const handle                = notifications().emplace_unlinked(std::move(command.notification), id); // It will be linked once admitted
+    notification_index().emplace(id, handle);
+    add_to_deduplication_index(*notifications().get(handle), handle, frame_time);
+    pending_notifications().push(notification_priority, handle);
+}
+
+static void apply(NotificationId id, ChangeCommand& command, TimePoint frame_time)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle handle) {
+        remove_from_deduplication_index(notification, handle);
+        notification.change(std::move(command.notification), frame_time);
+        add_to_deduplication_index(notification, handle, frame_time);
+    });
+}
+
+static void apply(NotificationId id, SetTitleCommand& command, TimePoint frame_time)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle handle) {
+        remove_from_deduplication_index(notification, handle);
+        notification.set_title(std::move(command.title), frame_time);
+        add_to_deduplication_index(notification, handle, frame_time);
+    });
+}
+
+static void apply(NotificationId id, SetContentCommand& command, TimePoint frame_time)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle handle) {
+        remove_from_deduplication_index(notification, handle);
+        notification.set_content(std::move(command.content), frame_time);
+        add_to_deduplication_index(notification, handle, frame_time);
+    });
+}
+
+static void apply(NotificationId id, SetTypeCommand const& command, TimePoint frame_time)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle handle) {
+        remove_from_deduplication_index(notification, handle);
+        notification.set_type(command.type, frame_time);
+        add_to_deduplication_index(notification, handle, frame_time);
+    });
+}
+
+static void apply(NotificationId id, SetDurationCommand const& command, TimePoint)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle) {
+        notification.set_duration(command.duration);
+    });
+}
+
+static void apply(NotificationId id, CloseAfterSmallDelayCommand const& command, TimePoint frame_time)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle) {
+        notification.close_after_at_most(command.delay, frame_time);
+    });
+}
+
+static void apply(NotificationId id, CloseImmediatelyCommand const&, TimePoint frame_time)
+{
+    with_notification(id, [&](NotificationImpl& notification, SlotHandle) {
+        notification.close_immediately(frame_time);
+    });
+}
+
+/// Shows how many notifications have been dropped because of a rate limit or of the capacity.
+/// All of them are counted in a single summary notification, which is updated as long as it is alive, so that the limits can't be bypassed by the summary itself.
+static void report_dropped_notifications()
+{
+    auto&           summary_id                 = dropped_notifications_summary_id();
+    static uint64_t dropped_since_summary_sent = 0;
+
+    uint64_t const rejected_sends = rejected_sends_count().exchange(0, std::memory_order_relaxed);
+    uint64_t const dropped_count  = dropped_notifications_count().exchange(0, std::memory_order_relaxed)
+                                   + (capacity().overflow_policy == OverflowPolicy::MergeIntoSummary ? rejected_sends : 0);
+    if (dropped_count == 0)
+        return;
+
+    bool const is_summary_alive = notification_index().contains(summary_id);
+    if (!is_summary_alive)
+        dropped_since_summary_sent = 0;
+    dropped_since_summary_sent += dropped_count;
+
+    auto summary = Notification{
+        .type    = Type::Warning,
+        .title   = "Notifications dropped",
+        .content = std::to_string(dropped_since_summary_sent) + (dropped_since_summary_sent == 1 ? " notification was" : " notifications were") + " dropped because too many notifications were sent.",
+    };
+    if (is_summary_alive)
+    {
+        push_command(summary_id, ChangeCommand{std::move(summary)});
+    }
+    else
+    {
+        summary_id = generate_notification_id();
+        push_command(summary_id, SendCommand{std::move(summary)});
+    }
+}
+
+/// All the pending commands that target the same notification, reduced to the ones that still have an effect
+/// They are applied in a canonical order: send, close immediately, change, field updates, close after a small delay
+/// This gives the same result as applying them one by one: close_immediately() forgets everything that came before it, and a change or duration that comes after a close_after_small_delay() forgets that close
+struct CoalescedCommands {
+    NotificationId id;
+    Command*       send{nullptr};
+    Command*       change{nullptr}; // Only the last change matters
+    Command*       set_title{nullptr};
+    Command*       set_content{nullptr};
+    Command*       set_type{nullptr};
+    Command*       set_duration{nullptr};
+    Command*       close_after_small_delay{nullptr}; // Only the shortest delay since the last change or duration matters
+    Command*       close_immediately{nullptr};
+
+    void forget_changes()
+    {
+        change       = nullptr;
+        set_title    = nullptr;
+        set_content  = nullptr;
+        set_type     = nullptr;
+        set_duration = nullptr;
+    }
+};
+
+static void coalesce(CoalescedCommands& coalesced, Command& command, SendCommand const&)
+{
+    coalesced.send = &command;
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, ChangeCommand const&)
+{
+    coalesced.forget_changes(); // The whole notification is replaced, so previous field updates don't matter anymore
+    coalesced.change                  = &command;
+    coalesced.close_after_small_delay = nullptr; // The new duration replaces the one set by the close, so the notification is revived
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, SetTitleCommand const&)
+{
+    coalesced.set_title = &command;
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, SetContentCommand const&)
+{
+    coalesced.set_content = &command;
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, SetTypeCommand const&)
+{
+    coalesced.set_type = &command;
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, SetDurationCommand const&)
+{
+    coalesced.set_duration            = &command;
+    coalesced.close_after_small_delay = nullptr; // The new duration replaces the one set by the close, so the notification is revived
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, CloseAfterSmallDelayCommand const& payload)
+{
+    if (coalesced.close_after_small_delay == nullptr
+        || payload.delay < std::get<CloseAfterSmallDelayCommand>(coalesced.close_after_small_delay->payload).delay)
+    {
+        coalesced.close_after_small_delay = &command;
+    }
+}
+static void coalesce(CoalescedCommands& coalesced, Command& command, CloseImmediatelyCommand const&)
+{
+    coalesced.forget_changes(); // They would never be seen. The changes that come after it are still applied after it, and can revive a notification that was already shown.
+    coalesced.close_immediately = &command;
+}
+
+// Reused every frame to avoid allocations
+static auto coalesced_commands() -> std::vector<CoalescedCommands>&
+{
+    static auto instance = std::vector<CoalescedCommands>{};
+    return instance;
+}
+// Index of the commands of each notification in coalesced_commands()
+static auto coalesced_commands_index() -> std::unordered_map<NotificationId, size_t>&
+{
+    static auto instance = std::unordered_map<NotificationId, size_t>{};
+    return instance;
+}
+
+static void apply_commands(TimePoint frame_time)
+{
+    Command* const first_command = commands().pop_all();
+    if (first_command == nullptr)
+        return;
+
+    // Commands are coalesced per notification, so that applying them scales with the number of notifications that changed, not with the number of commands
+    // (e.g. if a thread calls change() 50 times between two frames, only the last change gets applied)
+    auto& coalesced = coalesced_commands();
+    auto& index     = coalesced_commands_index();
+    coalesced.clear();
+    index.clear();
+    size_t commands_count = 0;
+    for (Command* command = first_command; command != nullptr; command = command->next)
+    {
+        auto const [it, is_new] = index.try_emplace(command->id, coalesced.size());
+        if (is_new)
+            coalesced.push_back({.id = command->id}); // Notifications are processed in the order of their first command, so that sends keep their order
+        std::visit([&](auto const& payload) { coalesce(coalesced[it->second], *command, payload); }, command->payload);
+        ++commands_count;
+    }
+
+    for (auto const& notification_commands : coalesced)
+    {
+        if (notification_commands.send != nullptr
+            && notification_commands.close_immediately != nullptr
+            && find_duplicate(std::get<SendCommand>(notification_commands.send->payload).notification, frame_time) == nullptr)
+        {
+            continue; // Sent and closed before being shown: the notification would never appear, so it doesn't even need to be created. (But if the send is merged into an existing notification, that one must be closed.)
+        }
+
+        auto const& c = notification_commands;
+        for (Command* const command : {c.send, c.close_immediately, c.change, c.set_title, c.set_content, c.set_type, c.set_duration, c.close_after_small_delay})
+        {
+            if (command != nullptr)
+                std::visit([&](auto& payload) { apply(command->id, payload, frame_time); }, command->payload);
+        }
+    }
+
+    Command* next = first_command;
+    while (next != nullptr)
+    {
+        auto const command = std::unique_ptr<Command>{next};
+        next               = command->next;
+    }
+    pending_commands_count().fetch_sub(commands_count, std::memory_order_relaxed);
+}
+
+static auto ImU32_from_ImVec4(ImVec4 color) -> ImU32
+{
+    return ImGui::GetColorU32(IM_COL32(
+        color.x * 255.f,
+        color.y * 255.f,
+        color.z * 255.f,
+        color.w * 255.f
+    ));
+}
+
+static auto background(ImVec4 color, float width, auto&& widget) -> ImRect // Takes any callable rather than a std::function, to make sure we never allocate
+{
+    ImDrawList& draw_list = *ImGui::GetWindowDrawList();
+    draw_list.ChannelsSplit(2);      // Allows us to draw the background rectangle behind the widget, even though the widget is drawn first.
+    draw_list.ChannelsSetCurrent(1); // We must draw them in that order because we need to know the height of the widget before drawing the rectangle.
+
+    ImVec2 const rectangle_start_pos = ImGui::GetCursorScreenPos() - ImGui::GetStyle().WindowPadding;
+
+    widget();
+
+    auto const rectangle_end_pos = ImVec2{
+        rectangle_start_pos.x + width,
+        ImGui::GetCursorScreenPos().y
+    };
+
+    auto const rect = ImRect{rectangle_start_pos, rectangle_end_pos};
+
+    draw_list.ChannelsSetCurrent(0);
+    draw_list.AddRectFilled(
+        rect.GetTL(),
+        rect.GetBR(),
+        ImU32_from_ImVec4(color)
+    );
+    draw_list.ChannelsMerge();
+
+    return rect;
+}
+
+static auto close_button(ImRect const title_bar_rect) -> bool
+{
+    bool has_closed{false};
+
+    ImGuiContext&      g{*GImGui};
+    ImGuiWindow* const window{ImGui::GetCurrentWindow()};
+    // Close button is on the Menu NavLayer and doesn't default focus (unless there's nothing else on that layer)
+    // FIXME-NAV: Might want (or not?) to set the equivalent of ImGuiButtonFlags_NoNavFocus so that mouse clicks on standard title bar items don't necessarily set nav/keyboard ref?
+    ImGuiItemFlags const item_flags_backup = g.CurrentItemFlags;
+    g.CurrentItemFlags |= ImGuiItemFlags_NoNavDefaultFocus;
+    window->DC.NavLayerCurrent = ImGuiNavLayer_Menu;
+
+    float const button_sz        = ImGui::GetFontSize();
+    auto const  close_button_pos = ImVec2{
+        title_bar_rect.Max.x - button_sz - ImGui::GetStyle().FramePadding.x,
+        title_bar_rect.GetCenter().y - button_sz * 0.5f,
+    };
+
+    if (ImGui::CloseButton(window->GetID("#CLOSE"), close_button_pos))
+        has_closed = true;
+
+    window->DC.NavLayerCurrent = ImGuiNavLayer_Main;
+    g.CurrentItemFlags         = item_flags_backup;
+
+    return has_closed;
+}
+
+/// The expiry timers depend on the fade durations of the style, so they must all be rescheduled when these change
+/// Otherwise shortening a duration would keep the notifications alive until their old deadline
+static void reschedule_expiry_timers_if_style_changed()
+{
+    static auto fade_durations = std::pair{get_style().fade_in_duration, get_style().fade_out_duration};
+
+    auto const current_fade_durations = std::pair{get_style().fade_in_duration, get_style().fade_out_duration};
+    if (current_fade_durations == fade_durations)
+        return;
+    fade_durations = current_fade_durations;
+    for (auto& notification : notifications()) // Pending notifications have no timer yet
+        notification.update_expiry_timer();
+}
+
+static void remove_expired_notifications(TimePoint frame_time)
+{
+    expiry_timers().pop_expired(frame_time, [&](TimerWheel<NotificationId>::Node const& timer) {
+        auto const it = notification_index().find(timer.value());
+        if (it == notification_index().end())
+            return;
+        auto const handle = it->second;
+        if (NotificationImpl* const notification = notifications().get(handle))
+        {
+            if (notification->has_expired(frame_time))
+                erase_notification(handle);
+            else
+                notification->update_expiry_timer(); // e.g. the style changed since it was scheduled
+        }
+    });
+}
+
+/// Splits `text` into the lines that ImFont::RenderText() would draw it on when wrapping it
+static void wrap_text(std::string_view text, TextLayoutKey const& key, TextLayout& layout)
+{
+    char const* const text_begin = text.data();
+    char const* const text_end   = text.data() + text.size();
+
+    layout.key  = key;
+    layout.size = ImGui::CalcTextSize(text_begin, text_end, false, key.wrap_width);
+    layout.lines.clear();
+
+    auto const add_line = [&](char const* begin, char const* end) {
+        layout.lines.push_back({static_cast<uint32_t>(begin - text_begin), static_cast<uint32_t>(end - text_begin)});
+    };
+
+    char const* line_begin = text_begin;
+    char const* wrap_pos   = nullptr; // Like ImFont::RenderText(), we keep the wrap position computed at the start of a line even after a '\n', because CalcWordWrapPositionA() doesn't stop at them
+    while (line_begin < text_end)
+    {
+        if (wrap_pos == nullptr)
+            wrap_pos = key.font->CalcWordWrapPositionA(key.font_size / key.font->FontSize, line_begin, text_end, key.wrap_width);
+
+        auto const* const newline = static_cast<char const*>(std::memchr(line_begin, '\n', static_cast<size_t>(wrap_pos - line_begin)));
+        if (newline != nullptr)
+        {
+            add_line(line_begin, newline);
+            line_begin = newline + 1;
+            continue;
+        }
+
+        add_line(line_begin, wrap_pos);
+        // Wrapping skips the upcoming blanks, and at most one '\n'
+        line_begin = wrap_pos;
+        wrap_pos   = nullptr;
+        while (line_begin < text_end && (*line_begin == ' ' || *line_begin == '\t'))
+            ++line_begin;
+        if (line_begin < text_end && *line_begin == '\n')
+            ++line_begin;
+    }
+}
+
+/// Same as ImGui::TextUnformatted() inside an ImGui::PushTextWrapPos(), but only wraps the text again when `layout` is not valid anymore
+static void text_unformatted_wrapped(std::string_view text, size_t text_hash, TextLayout& layout)
+{
+    ImGuiWindow& window = *ImGui::GetCurrentWindow();
+    if (window.DC.TextWrapPos < 0.f)
+    {
+        ImGui::TextUnformatted(text.data(), text.data() + text.size()); // Not wrapped, so there is nothing to cache
+        return;
+    }
+    if (ImGui::GetFontSize() != std::floor(ImGui::GetFontSize()))
+    {
+        // ImFont::RenderText() truncates the position of the text once, and then moves down by the font size for each line, whereas we truncate the position of each line
+        // This only gives the same positions when the font size is a whole number of pixels, which is not the case with e.g. io.FontGlobalScale = 1.25
+        ImGui::TextUnformatted(text.data(), text.data() + text.size());
+        return;
+    }
+
+    auto const key = TextLayoutKey{
+        .text_hash  = text_hash,
+        .wrap_width = ImGui::CalcWrapWidthForPos(window.DC.CursorPos, window.DC.TextWrapPos),
+        .font       = ImGui::GetFont(),
+        .font_size  = ImGui::GetFontSize(),
+    };
+    if (layout.key != key)
+        wrap_text(text, key, layout);
+
+    auto const text_pos = ImVec2{window.DC.CursorPos.x, window.DC.CursorPos.y + window.DC.CurrLineTextBaseOffset};
+    ImGui::ItemSize(layout.size, 0.f);
+    if (!ImGui::ItemAdd(ImRect{text_pos, text_pos + layout.size}, 0))
+        return;
+
+    ImU32 const color  = ImGui::GetColorU32(ImGuiCol_Text);
+    float       line_y = static_cast<float>(static_cast<int>(text_pos.y)); // Truncated once for the whole text, like ImFont::RenderText() does, so that the lines are spaced exactly the same
+    for (TextLayout::Line const& line : layout.lines)
+    {
+        window.DrawList->AddText(key.font, key.font_size, ImVec2{text_pos.x, line_y}, color, text.data() + line.begin, text.data() + line.end);
+        line_y += key.font_size;
+    }
+}
+
+/// Renders the title bar and content of a notification (everything but its close button), at the current cursor position, and returns the rect of the title bar
+static auto render_notification_body(NotificationImpl& notif, float width, Layout const* layout) -> ImRect
+{
+    // Title bar
+    auto const title_bar_widgets = [&]() {
+        ImGui::TextColored(notif.color(), "%s", notif.icon());
+        ImGui::SameLine();
+        ImGui::TextUnformatted(notif.title().c_str());
+        if (notif.occurrences_count() > 1)
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("\xC3\x97%u", notif.occurrences_count()); // "×" encoded in UTF-8
+        }
+    };
+    auto title_bar_rect = ImRect{};
+    if (layout != nullptr)
+    {
+        // We already know the height of the title bar, so we can draw its background first, without having to split the draw list like background() does
+        ImVec2 const title_bar_pos = ImGui::GetCursorScreenPos() - ImGui::GetStyle().WindowPadding;
+        title_bar_rect             = ImRect{title_bar_pos, title_bar_pos + ImVec2{width, layout->title_bar_height}};
+        ImGui::GetWindowDrawList()->AddRectFilled(title_bar_rect.Min, title_bar_rect.Max, ImU32_from_ImVec4(get_style().color_title_background));
+        title_bar_widgets();
+    }
+    else
+    {
+        title_bar_rect = background(get_style().color_title_background, width, title_bar_widgets);
+    }
+
+    // Content
+    if (notif.has_content())
+    {
+        // Add a small padding after the title
+        ImGui::Dummy({0.f, 5.f});
+
+        if (!notif.content().empty())
+            text_unformatted_wrapped(notif.content(), notif.content_hash(), notif.content_layout());
+        if (notif.custom_imgui_content())
+            notif.custom_imgui_content()();
+        if (notif.progress())
+            ImGui::ProgressBar(std::clamp(notif.progress()->load(std::memory_order_relaxed), 0.f, 1.f), ImVec2{width - 2.f * ImGui::GetStyle().WindowPadding.x, 0.f});
+    }
+
+    return title_bar_rect;
+}
+
+static auto current_geometry_key(NotificationImpl const& notif, LayoutKey const& layout_key) -> GeometryKey
+{
+    ImDrawList const& draw_list = *ImGui::GetWindowDrawList();
+    return {
+        .layout                 = layout_key,
+        .icon_color             = ImGui::GetColorU32(notif.color()),
+        .title_background_color = ImU32_from_ImVec4(get_style().color_title_background),
+        .text_color             = ImGui::GetColorU32(ImGuiCol_Text),
+        .text_disabled_color    = ImGui::GetColorU32(ImGuiCol_TextDisabled),
+        .texture                = draw_list._CmdHeader.TextureId,
+        .white_pixel_uv         = draw_list._Data->TexUvWhitePixel,
+    };
+}
+
+/// Same as render_notification_body(), but replays the geometry generated during a previous frame if it is still valid, instead of submitting all the widgets again
+static auto render_notification_body_with_cached_geometry(NotificationImpl& notif, float width, Layout const& layout) -> ImRect
+{
+    ImDrawList&       draw_list = *ImGui::GetWindowDrawList();
+    ImVec2 const      origin    = ImGui::GetCursorScreenPos();
+    GeometryKey const key       = current_geometry_key(notif, layout.key);
+
+    if (Geometry const* const geometry = notif.cached_geometry(key))
+    {
+        draw_list.PrimReserve(static_cast<int>(geometry->indices.size()), static_cast<int>(geometry->vertices.size()));
+        auto const first_vertex_index = draw_list._VtxCurrentIdx; // Read after PrimReserve(), which might have started a new range of vertices
+        for (ImDrawIdx const index : geometry->indices)
+            draw_list.PrimWriteIdx(static_cast<ImDrawIdx>(first_vertex_index + index));
+        for (ImDrawVert const& vertex : geometry->vertices)
+            draw_list.PrimWriteVtx(vertex.pos + origin, vertex.uv, vertex.col);
+        ImGui::Dummy(geometry->content_size); // Takes the same space as the widgets it replaces
+
+        ImVec2 const title_bar_pos = origin - ImGui::GetStyle().WindowPadding;
+        return ImRect{title_bar_pos, title_bar_pos + ImVec2{width, layout.title_bar_height}};
+    }
+
+    int const          first_vertex       = draw_list.VtxBuffer.Size;
+    int const          first_index        = draw_list.IdxBuffer.Size;
+    int const          commands_count     = draw_list.CmdBuffer.Size;
+    unsigned int const vertices_offset    = draw_list._CmdHeader.VtxOffset;
+    unsigned int const first_vertex_index = draw_list._VtxCurrentIdx;
+
+    ImRect const title_bar_rect = render_notification_body(notif, width, &layout);
+
+    // The geometry can only be replayed if it all belongs to the same draw command, and if none of it has been culled because it was outside of the clip rect
+    auto const content_rect = ImRect{origin, ImGui::GetCurrentWindow()->DC.CursorMaxPos};
+    if (draw_list.CmdBuffer.Size == commands_count
+        && draw_list._CmdHeader.VtxOffset == vertices_offset
+        && ImRect{draw_list.GetClipRectMin(), draw_list.GetClipRectMax()}.Contains(content_rect))
+    {
+        auto geometry = Geometry{.key = key, .content_size = content_rect.GetSize(), .vertices = {}, .indices = {}};
+        geometry.vertices.reserve(static_cast<size_t>(draw_list.VtxBuffer.Size - first_vertex));
+        for (int i = first_vertex; i < draw_list.VtxBuffer.Size; ++i)
+        {
+            ImDrawVert vertex = draw_list.VtxBuffer[i];
+            vertex.pos -= origin;
+            geometry.vertices.push_back(vertex);
+        }
+        geometry.indices.reserve(static_cast<size_t>(draw_list.IdxBuffer.Size - first_index));
+        for (int i = first_index; i < draw_list.IdxBuffer.Size; ++i)
+            geometry.indices.push_back(static_cast<ImDrawIdx>(draw_list.IdxBuffer[i] - first_vertex_index));
+        notif.set_cached_geometry(std::move(geometry));
+    }
+
+    return title_bar_rect;
+}
+
+/// Renders the title bar, close button and content of a notification, at the current cursor position
+/// `width` is the width of the notification, including its padding
+/// `layout` is the layout measured during a previous frame, or nullptr if it must be measured again
+/// Returns the height of the title bar
+static auto render_notification_content(NotificationImpl& notif, float width, Layout const* layout, TimePoint frame_time) -> float
+{
+    ImRect const title_bar_rect = layout != nullptr && !notif.progress() // The progress bar can change at any time
+                                      ? render_notification_body_with_cached_geometry(notif, width, *layout)
+                                      : render_notification_body(notif, width, layout);
+
+    // Close button. Rendered last, and never cached, so that it stays interactive
+    if (notif.is_closable())
+    {
+        if (close_button(title_bar_rect))
+            notif.close_immediately(frame_time);
+    }
+
+    return title_bar_rect.GetHeight();
+}
+
+static auto next_required_frame_time_instance() -> std::optional<TimePoint>&
+{
+    static auto instance = std::optional<TimePoint>{};
+    return instance;
+}
+
+auto next_required_frame_time() -> std::optional<TimePoint>
+{
+    return next_required_frame_time_instance();
+}
+
+static void request_frame_at(std::optional<TimePoint> time)
+{
+    if (!time.has_value())
+        return;
+    auto& next_frame_time = next_required_frame_time_instance();
+    if (!next_frame_time.has_value() || *time < *next_frame_time)
+        next_frame_time = time;
+}
+
+struct SizeCallbackData {
+    NotificationImpl* notification;
+    float             fade_percent;
+    TimePoint         frame_time;
+};
+
+// Height of the last notification that has been fully displayed. Used for the notifications that have never been rendered yet (or that are still fading in), to know how much space they will take.
+static auto estimated_notification_height() -> float&
+{
+    static float instance{100.f};
+    return instance;
+}
+
+/// Renders `notif` in its own window, stacked above the windows that have a total height of `height`, and increases `height` by the height of this window
+static void render_notification_window(NotificationImpl& notif, float& height, TimePoint frame_time)
+{
+    ImVec2 const main_window_pos  = ImGui::GetMainViewport()->Pos;
+    ImVec2 const main_window_size = ImGui::GetMainViewport()->Size;
+
+    notif.init_creation_time_ifn(frame_time); // Init creation time the first time a notification is shown, because if they are outside the window they might prevent it from showing for a while, and we don't want it to disappear immediately after appearing
+
+    bool const can_reuse_layout = notif.can_reuse_layout(frame_time);
+
+    auto size_callback_data = SizeCallbackData{
+        .notification = &notif,
+        .fade_percent = can_reuse_layout ? 1.f : notif.fade_percent(frame_time), // Not animating, so no need to compute it
+        .frame_time   = frame_time,
+    };
+
+    // Set window position and size
+    ImGui::SetNextWindowPos(
+        ImVec2{
+            main_window_pos.x + main_window_size.x - get_style().padding_x,
+            main_window_pos.y + main_window_size.y - get_style().padding_y - height
+        },
+        ImGuiCond_Always, ImVec2{1.f, 1.f}
+    );
+    if (can_reuse_layout)
+    {
+        ImGui::SetNextWindowSizeConstraints(ImVec2{get_style().min_width, 0.f}, ImVec2{FLT_MAX, FLT_MAX}); // Not animating, so there is nothing to crop
+    }
+    else
+    {
         ImGui::SetNextWindowSizeConstraints(
             ImVec2{get_style().min_width, 0.f}, // Min width
             ImVec2{FLT_MAX, FLT_MAX},
             [](ImGuiSizeCallbackData* data) {
                 // in / out transition by cropping the window size
-                NotificationImpl& notif = *reinterpret_cast<NotificationImpl*>(data->UserData); // NOLINT(*reinterpret-cast)
-                data->DesiredSize.y *= notif.fade_percent();
-                notif.apply_window_height_transition_ifn(data->DesiredSize.y);
+                auto const& callback_data = *reinterpret_cast<SizeCallbackData const*>(data->UserData); // NOLINT(*reinterpret-cast)
+                data->DesiredSize.y *= callback_data.fade_percent;
+                callback_data.notification->apply_window_height_transition_ifn(data->DesiredSize.y, callback_data.frame_time);
             },
-            (void*)&notif // NOLINT(*casting)
+            (void*)&size_callback_data // NOLINT(*casting)
         );
+    }
+
+    ImGui::PushStyleColor(ImGuiCol_Border, notif.color());
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, get_style().border_width);
+    ImGui::Begin(notif.window_name(), nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoFocusOnAppearing);
+
+    // Render over all other windows
+    ImGui::BringWindowToDisplayFront(ImGui::GetCurrentWindow());
+
+    // Keep alive if hovered
+    notif.set_hovered(ImGui::IsWindowHovered(), frame_time);
+
+    // Here we render the content
+    float const     width      = ImGui::GetWindowWidth();
+    LayoutKey const layout_key = current_layout_key(width);
+    Layout const*   layout     = can_reuse_layout ? notif.cached_layout(layout_key) : nullptr;
+    ImGui::PushTextWrapPos(width); // Support multi-line text
+    float const title_bar_height = render_notification_content(notif, width, layout, frame_time);
+    ImGui::PopTextWrapPos();
+
+    request_frame_at(notif.next_change_time(frame_time));
+
+    // Update height for next notification
+    float const window_height = ImGui::GetWindowHeight();
+    notif.set_window_height(window_height);
+    if (can_reuse_layout && layout == nullptr)
+        notif.set_cached_layout({.key = layout_key, .title_bar_height = title_bar_height, .full_height = window_height}); // The window is not cropped, so this is its full height
+    if (size_callback_data.fade_percent == 1.f)
+        estimated_notification_height() = window_height;
+    height += window_height + get_style().padding_between_notifications_y * size_callback_data.fade_percent;
+
+    // End
+    ImGui::End();
+    ImGui::PopStyleVar();
+    ImGui::PopStyleColor();
+}
 
-        ImGui::PushStyleColor(ImGuiCol_Border, notif.color());
-        ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, get_style().border_width);
-        ImGui::Begin(("##notification" + std::to_string(notif.unique_id()._id)).c_str(), nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoFocusOnAppearing);
+static void render_one_window_per_notification(TimePoint frame_time)
+{
+    card_stack().mark_for_rebuild(); // It is not kept up to date in this mode
+
+    // Notifications that don't fit on screen stay pending until the ones below them disappear. Use Style::single_window if you want to be able to scroll to them instead.
+    auto const is_full = [&](float height) {
+        return height > ImGui::GetMainViewport()->Size.y - 100.f;
+    };
+
+    float height = 0.f;
+    for (auto& notif : notifications())
+    {
+        if (is_full(height))
+            return;
+        render_notification_window(notif, height, frame_time);
+    }
+    while (!is_full(height))
+    {
+        NotificationImpl* const notif = admit_next_pending_notification();
+        if (notif == nullptr)
+            break;
+        float const height_before = height;
+        render_notification_window(*notif, height, frame_time);
+        // It is still tiny because it just started fading in, but it will soon take its full height, so we must not admit more notifications than can fit
+        height = std::max(height, height_before + estimated_notification_height() + get_style().padding_between_notifications_y);
+    }
+}
+
+// The title bar uses the splitter of the draw list (see background()), so the cards need their own one, because splits can't be nested
+// Reused every frame to avoid allocations
+static auto card_splitter() -> ImDrawListSplitter&
+{
+    static auto instance = ImDrawListSplitter{};
+    return instance;
+}
+
+/// Renders a notification inside the window that hosts all the notifications, as a card at the current cursor position
+/// Like the individual windows, the card is cropped to `visible_height` during its in / out and change transitions
+static void render_notification_card(NotificationImpl& notif, float visible_height, float spacing, TimePoint frame_time)
+{
+    ImGuiWindow& host_window  = *ImGui::GetCurrentWindow();
+    ImDrawList&  draw_list    = *ImGui::GetWindowDrawList();
+    ImVec2 const padding      = ImGui::GetStyle().WindowPadding;
+    float const  width        = get_style().min_width;
+    ImVec2 const card_pos     = ImGui::GetCursorScreenPos();
+    auto const   visible_rect = ImRect{card_pos, card_pos + ImVec2{width, visible_height}};
+
+    notif.set_hovered(ImGui::IsWindowHovered() && ImGui::IsMouseHoveringRect(visible_rect.Min, visible_rect.Max), frame_time);
+
+    auto const draw_card_background = [&](float full_height) {
+        auto const card_rect = ImRect{card_pos, card_pos + ImVec2{width, full_height}};
+        draw_list.AddRectFilled(card_rect.Min, card_rect.Max, ImGui::GetColorU32(ImGuiCol_WindowBg));
+        draw_list.AddRect(card_rect.Min, card_rect.Max, ImU32_from_ImVec4(notif.color()), 0.f, 0, get_style().border_width);
+    };
+
+    bool const      can_reuse_layout = notif.can_reuse_layout(frame_time);
+    LayoutKey const layout_key       = current_layout_key(width);
+    Layout const*   layout           = can_reuse_layout ? notif.cached_layout(layout_key) : nullptr;
+
+    float const cursor_max_y = host_window.DC.CursorMaxPos.y;
+    ImGui::PushID(notif.window_name());
+    ImGui::PushClipRect(visible_rect.Min, visible_rect.Max, true);
+    if (layout != nullptr)
+    {
+        draw_card_background(layout->full_height); // We already know the height of the card, so we can draw its background first
+    }
+    else
+    {
+        card_splitter().Split(&draw_list, 2); // Draw the card background behind its content, even though we only know its height after rendering the content
+        card_splitter().SetCurrentChannel(&draw_list, 1);
+    }
+
+    ImGui::SetCursorScreenPos(card_pos + padding);
+    ImGui::BeginGroup();
+    ImGui::PushTextWrapPos(ImGui::GetCursorPos().x + width - 2.f * padding.x); // Support multi-line text
+    float const title_bar_height = render_notification_content(notif, width, layout, frame_time);
+    ImGui::PopTextWrapPos();
+    ImGui::EndGroup();
+
+    if (layout == nullptr)
+    {
+        float const full_height = ImGui::GetItemRectMax().y - card_pos.y + padding.y;
+        notif.set_window_height(full_height);
+        estimated_notification_height() = full_height;
+        if (can_reuse_layout)
+            notif.set_cached_layout({.key = layout_key, .title_bar_height = title_bar_height, .full_height = full_height});
+
+        card_splitter().SetCurrentChannel(&draw_list, 0);
+        draw_card_background(full_height);
+        card_splitter().Merge(&draw_list);
+    }
+    ImGui::PopClipRect();
+    ImGui::PopID();
+
+    // Only the visible part of the card takes space in the layout
+    host_window.DC.CursorMaxPos.y = cursor_max_y;
+    ImGui::SetCursorScreenPos(card_pos);
+    ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2{0.f, 0.f}); // `spacing` already is the spacing between cards
+    ImGui::Dummy({width, visible_height + spacing});
+    ImGui::PopStyleVar();
+}
+
+/// Height that the card of `notif` takes in the single window
+static auto card_height(NotificationImpl& notif, TimePoint now) -> CardHeight
+{
+    // Cards that have never been seen take their full height, so that the user can scroll to them
+    float const fade   = notif.has_been_init() ? notif.fade_percent(now) : 1.f;
+    float       height = notif.window_height().value_or(estimated_notification_height()) * fade;
+    notif.apply_window_height_transition_ifn(height, now);
+    return {height, get_style().padding_between_notifications_y * fade};
+}
 
-        // Render over all other windows
-        ImGui::BringWindowToDisplayFront(ImGui::GetCurrentWindow());
+void CardStack::push_back(NotificationImpl& notif, SlotHandle handle)
+{
+    if (_needs_rebuild)
+        return;
+    notif.card() = CardState{.index = static_cast<uint32_t>(_handles.size())};
+    _handles.push_back(handle);
+    _heights.emplace_back();
+    _sums.push_back(0.f);
+    mark_for_update(notif, handle); // Its height will be computed by the next update()
+}
+
+void CardStack::erase(NotificationImpl& notif)
+{
+    if (_needs_rebuild || !notif.is_admitted())
+        return;
+    _heights[notif.card().index] = {};
+    _sums.set(notif.card().index, 0.f);
+    ++_erased_count;
+    if (2 * _erased_count > _handles.size()) // Don't let the empty cards accumulate
+        mark_for_rebuild();
+}
+
+void CardStack::mark_for_update(NotificationImpl& notif, SlotHandle handle)
+{
+    if (_needs_rebuild || !notif.is_admitted() || notif.card().needs_update)
+        return;
+    notif.card().needs_update = true;
+    _cards_to_update.push_back(handle);
+}
+
+void CardStack::update(TimePoint now)
+{
+    auto const style = StyleSnapshot{
+        .padding_between_notifications_y = get_style().padding_between_notifications_y,
+        .fade_in_duration                = get_style().fade_in_duration,
+        .fade_out_duration               = get_style().fade_out_duration,
+        .change_duration                 = get_style().change_duration,
+    };
+    if (style != _style)
+    {
+        _style = style;
+        mark_for_rebuild();
+    }
 
-        // Keep alive if hovered
-        notif.set_hovered(ImGui::IsWindowHovered());
+    if (_needs_rebuild)
+    {
+        rebuild(now);
+    }
+    else
+    {
+        while (!_fade_outs.empty() && _fade_outs.front().time <= now)
+        {
+            std::pop_heap(_fade_outs.begin(), _fade_outs.end());
+            FadeOut const fade_out = _fade_outs.back();
+            _fade_outs.pop_back();
+            NotificationImpl* const notif = notifications().get(fade_out.handle);
+            if (notif == nullptr || notif->card().fade_out_time != fade_out.time)
+                continue; // Stale
+            notif->card().fade_out_time.reset();
+            mark_for_update(*notif, fade_out.handle);
+        }
+
+        std::swap(_cards_to_update, _cards_being_updated);
+        _cards_to_update.clear();
+        for (SlotHandle const handle : _cards_being_updated)
+        {
+            NotificationImpl* const notif = notifications().get(handle);
+            if (notif == nullptr)
+                continue;
+            notif->card().needs_update = false;
+            update_card(*notif, handle, now);
+        }
+    }
 
-        // Here we render the content
+    // The cards that are not animating will need a frame when they start fading out
+    while (!_fade_outs.empty())
+    {
+        NotificationImpl* const notif = notifications().get(_fade_outs.front().handle);
+        if (notif != nullptr && notif->card().fade_out_time == _fade_outs.front().time)
         {
-            ImGui::PushTextWrapPos(ImGui::GetWindowWidth()); // Support multi-line text
+            request_frame_at(_fade_outs.front().time);
+            break;
+        }
+        std::pop_heap(_fade_outs.begin(), _fade_outs.end()); // Stale
+        _fade_outs.pop_back();
+    }
+}
+
+void CardStack::rebuild(TimePoint now)
+{
+    _handles.clear();
+    _heights.clear();
+    _sums.clear();
+    _cards_to_update.clear();
+    _fade_outs.clear();
+    _erased_count  = 0;
+    _needs_rebuild = false;
+    for (auto it = notifications().begin(); it != notifications().end(); ++it)
+    {
+        it->card() = CardState{.index = static_cast<uint32_t>(_handles.size())};
+        _handles.push_back(it.handle());
+        _heights.emplace_back();
+        _sums.push_back(0.f);
+        update_card(*it, it.handle(), now);
+    }
+}
+
+void CardStack::update_card(NotificationImpl& notif, SlotHandle handle, TimePoint now)
+{
+    CardHeight const height = card_height(notif, now);
+    _heights[notif.card().index] = height;
+    _sums.set(notif.card().index, height.height + height.spacing);
+
+    auto const next_change_time = notif.next_change_time(now);
+    if (next_change_time == now)
+    {
+        request_frame_at(now);
+        mark_for_update(notif, handle); // It is still animating
+    }
+    else
+    {
+        schedule_fade_out(notif, handle, next_change_time);
+    }
+}
+
+void CardStack::schedule_fade_out(NotificationImpl& notif, SlotHandle handle, std::optional<TimePoint> time)
+{
+    if (notif.card().fade_out_time == time)
+        return;
+    notif.card().fade_out_time = time;
+    if (!time)
+        return;
+    _fade_outs.push_back({*time, handle});
+    std::push_heap(_fade_outs.begin(), _fade_outs.end());
+    if (_fade_outs.size() > 2 * _handles.size()) // There is at most one entry per card that is not stale, so the stale ones are the majority (e.g. because a card has been hovered for a long time)
+    {
+        std::erase_if(_fade_outs, [](FadeOut const& fade_out) {
+            NotificationImpl* const notif = notifications().get(fade_out.handle);
+            return notif == nullptr || notif->card().fade_out_time != fade_out.time;
+        });
+        std::make_heap(_fade_outs.begin(), _fade_outs.end());
+    }
+}
+
+// Reused every frame to avoid allocations
+static auto newly_admitted_notifications() -> std::vector<SlotHandle>&
+{
+    static auto instance = std::vector<SlotHandle>{};
+    return instance;
+}
+
+static void render_single_window(TimePoint frame_time)
+{
+    if (notifications().empty())
+        return;
+
+    // Everything can be scrolled to, so all the pending notifications are displayed right away, and the most important ones are stacked at the bottom (see admit_next_pending_notification())
+    auto& newly_admitted = newly_admitted_notifications();
+    newly_admitted.clear();
+    while (NotificationImpl const* const notif = admit_next_pending_notification())
+        newly_admitted.push_back(notification_index().at(notif->unique_id()));
+
+    // Only visits the cards that are animating or that have changed, see CardStack
+    CardStack& stack = card_stack();
+    stack.update(frame_time);
+
+    ImVec2 const main_window_pos  = ImGui::GetMainViewport()->Pos;
+    ImVec2 const main_window_size = ImGui::GetMainViewport()->Size;
+    ImGui::SetNextWindowPos(
+        ImVec2{
+            main_window_pos.x + main_window_size.x - get_style().padding_x,
+            main_window_pos.y + main_window_size.y - get_style().padding_y
+        },
+        ImGuiCond_Always, ImVec2{1.f, 1.f}
+    );
+    float const max_window_height = main_window_size.y - 2.f * get_style().padding_y;
+    ImGui::SetNextWindowSizeConstraints(ImVec2{0.f, 0.f}, ImVec2{FLT_MAX, max_window_height});
+
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2{0.f, 0.f});
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.f);
+    ImGui::Begin("##ImGuiNotify", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoFocusOnAppearing);
+    ImGui::PopStyleVar(2); // The cards use the normal style.WindowPadding for their content
+
+    // Render over all other windows
+    ImGui::BringWindowToDisplayFront(ImGui::GetCurrentWindow());
+
+    // Like a log, stay scrolled to the bottom (where the oldest notifications are) unless the user scrolled up
+    bool const is_scrolled_to_bottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+    // The list is virtualized: only the cards that are visible are laid out and rendered, the other ones just reserve their (cached) height in the scrollable area.
+    // We decide what is visible in content space rather than with the clip rect of the window, because the window only resizes to fit its content one frame later.
+    float const content_height = stack.total_height();
+    float const window_height  = std::min(content_height, max_window_height);
+    float const scroll_y       = is_scrolled_to_bottom
+                                     ? content_height - window_height
+                                     : std::min(ImGui::GetScrollY(), content_height - window_height);
+    // The stack is measured from its bottom, while the window is laid out from its top
+    float const visible_bottom = content_height - scroll_y - window_height;
+    float const visible_top    = content_height - scroll_y;
+
+    size_t const first_visible  = stack.first_card_above(visible_bottom);
+    size_t       end_of_visible = first_visible;
+    for (float card_top = stack.bottom(first_visible); end_of_visible < stack.size(); ++end_of_visible)
+    {
+        auto const [height, spacing] = stack.height(end_of_visible);
+        card_top += height + spacing;
+        if (card_top - std::max(height, 1.f) >= visible_top)
+            break;
+    }
+
+    auto const reserve_height = [&](float height) {
+        if (height <= 0.f)
+            return;
+        ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2{0.f, 0.f}); // Spacing between cards is already included in the height
+        ImGui::Dummy({get_style().min_width, height});
+        ImGui::PopStyleVar();
+    };
 
-            // Title bar
-            auto const title_bar_rect = background(get_style().color_title_background, [&]() {
-                ImGui::TextColored(notif.color(), "%s", notif.icon());
-                ImGui::SameLine();
-                ImGui::TextUnformatted(notif.title().c_str());
-            });
+    reserve_height(content_height - stack.bottom(end_of_visible));
+    size_t erased_cards_count = 0;
+    for (size_t index = end_of_visible; index-- > first_visible;) // From top to bottom
+    {
+        SlotHandle const        handle = stack.handle(index);
+        NotificationImpl* const notif  = notifications().get(handle);
+        if (notif == nullptr)
+        {
+            ++erased_cards_count; // It has an empty height
+            continue;
+        }
+        auto [height, spacing] = stack.height(index);
 
-            // Close button
-            if (notif.is_closable())
+        if (!notif->has_been_init())
+        {
+            // Only start the timer once the notification has actually been seen
+            if (notif->has_been_off_screen())
             {
-                if (close_button(title_bar_rect))
-                    notif.close_immediately();
+                notif->init_creation_time_without_fade_in(frame_time); // It was already taking its full height while off screen, so it must not shrink to animate in
             }
-
-            // Content
-            if (notif.has_content())
+            else
             {
-                // Add a small padding after the title
-                ImGui::Dummy({0.f, 5.f});
-
-                if (!notif.content().empty())
-                    ImGui::TextUnformatted(notif.content().c_str());
-                if (notif.custom_imgui_content())
-                    notif.custom_imgui_content()();
+                notif->init_creation_time_ifn(frame_time);
+                float const fade = notif->fade_percent(frame_time);
+                height           = notif->window_height().value_or(0.f) * fade;
+                spacing          = get_style().padding_between_notifications_y * fade;
             }
-
-            ImGui::PopTextWrapPos();
+            request_frame_at(notif->next_change_time(frame_time)); // It has just started its timer
         }
+        render_notification_card(*notif, height, spacing, frame_time);
+        stack.mark_for_update(*notif, handle); // Rendering can change its height, e.g. because it is hovered or because it has been measured
+    }
+    reserve_height(stack.bottom(first_visible));
+    for (SlotHandle const handle : newly_admitted)
+    {
+        NotificationImpl* const notif = notifications().get(handle);
+        if (notif != nullptr && !notif->has_been_init()) // It is not visible
+            notif->set_has_been_off_screen();
+    }
+    if (erased_cards_count > end_of_visible - first_visible - erased_cards_count)
+        stack.mark_for_rebuild(); // Don't keep visiting them
 
-        // Update height for next notification
-        float const window_height = ImGui::GetWindowHeight();
-        notif.set_window_height(window_height);
-        height += window_height + get_style().padding_between_notifications_y * notif.fade_percent();
+    if (is_scrolled_to_bottom)
+        ImGui::SetScrollHereY(1.f);
 
-        // End
-        ImGui::End();
-        ImGui::PopStyleVar();
-        ImGui::PopStyleColor();
+    ImGui::End();
+}
+
+static auto last_frame_allocation_stats_instance() -> AllocationStats&
+{
+    static auto instance = AllocationStats{};
+    return instance;
+}
+
+auto last_frame_allocation_stats() -> AllocationStats
+{
+    return last_frame_allocation_stats_instance();
+}
+
+void render_windows()
+{
+    AllocationStats const allocations_before = thread_allocation_stats();
+    TimePoint const       frame_time         = now(); // The only time we read the clock during the frame
+    next_required_frame_time_instance().reset();
+
+    report_dropped_notifications(); // Before applying the commands, so that the summary is shown this frame
+    apply_commands(frame_time);
+
+    reschedule_expiry_timers_if_style_changed();
+    remove_expired_notifications(frame_time);
+
+    if (get_style().single_window)
+        render_single_window(frame_time);
+    else
+        render_one_window_per_notification(frame_time);
+
+    if (!commands().is_empty())
+        request_frame_at(frame_time); // Commands have been pushed by a custom_imgui_content(), and need to be applied
+
+    // ImGui windows resize to fit their content one frame late, so we need to keep rendering for a few frames after the animations stop
+    static int frames_to_settle = 0;
+    if (next_required_frame_time_instance() == frame_time)
+        frames_to_settle = 2;
+    else if (frames_to_settle > 0)
+    {
+        --frames_to_settle;
+        request_frame_at(frame_time);
     }
+
+    AllocationStats const allocations_after = thread_allocation_stats();
+    last_frame_allocation_stats_instance() = {
+        .count = allocations_after.count - allocations_before.count,
+        .bytes = allocations_after.bytes - allocations_before.bytes,
+    };
 }
 
 void add_icons_to_current_font(float icon_size, ImVec2 glyph_offset)
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+
+namespace ImGuiNotify {
+
+/// Lock-free multi-producer / single-consumer queue of intrusively-linked nodes.
+/// Producers push with a single compare-and-swap and never block, and the consumer grabs everything that has been pushed so far with a single exchange.
+/// `Node` must have a `Node* next` member. The queue does not own the nodes: whoever pops them is responsible for deleting them.
+template<typename Node>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+    ~MpscQueue()                               = default;
+    MpscQueue(MpscQueue const&)                = delete;
+    MpscQueue& operator=(MpscQueue const&)     = delete;
+    MpscQueue(MpscQueue&&) noexcept            = delete;
+    MpscQueue& operator=(MpscQueue&&) noexcept = delete;
+
+    /// Can be called from any thread
+    void push(Node* node)
+    {
+        Node* head = _head.load(std::memory_order_relaxed);
+        do // NOLINT(*avoid-do-while)
+        {
+            node->next = head;
+        } while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// Pushes several nodes at once, with a single compare-and-swap
+    /// `newest` must be linked through `next` down to `oldest`, i.e. in the opposite order of the one in which they will be popped
+    /// Can be called from any thread
+    void push_chain(Node* newest, Node* oldest)
+    {
+        Node* head = _head.load(std::memory_order_relaxed);
+        do // NOLINT(*avoid-do-while)
+        {
+            oldest->next = head;
+        } while (!_head.compare_exchange_weak(head, newest, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// Returns all the nodes pushed so far, linked in the order they were pushed (oldest first)
+    /// Must only be called from the consumer thread
+    auto pop_all() -> Node*
+    {
+        Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+        // The nodes are stacked newest first, so we reverse the list to replay them in order
+        Node* reversed = nullptr;
+        while (node != nullptr)
+        {
+            Node* const next = node->next;
+            node->next       = reversed;
+            reversed         = node;
+            node             = next;
+        }
+        return reversed;
+    }
+
+    auto is_empty() const -> bool { return _head.load(std::memory_order_relaxed) == nullptr; }
+
+private:
+    std::atomic<Node*> _head{nullptr};
+};
+
+} // namespace ImGuiNotify
@@ -0,0 +1,232 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ImGuiNotify {
+
+struct SlotHandle {
+    uint32_t index{};
+    uint32_t generation{};
+
+    friend auto operator==(SlotHandle const&, SlotHandle const&) -> bool = default;
+};
+
+/// Pool of values that never move in memory once they have been inserted.
+/// Insertion and removal are O(1), and handles to a removed value are rejected thanks to a generation counter, even if its slot has been reused since.
+/// Values are also linked in insertion order, so that iterating gives them back in the order they were inserted.
+/// Values inserted with emplace_unlinked() are skipped by the iteration until they are linked with move_to_back().
+template<typename T>
+class SlotMap {
+    static constexpr uint32_t npos{UINT32_MAX};
+    static constexpr uint32_t chunk_size{64};
+
+    struct Slot {
+        std::optional<T> value{};
+        uint32_t         generation{0};
+        uint32_t         previous{npos};
+        uint32_t         next{npos}; // Next value in insertion order, or next free slot if this slot is free
+        bool             is_linked{false};
+    };
+
+    template<bool IsReversed>
+    class BasicIterator {
+    public:
+        auto operator*() const -> T& { return *_map->slot_at(_index).value; }
+        auto operator->() const -> T* { return &*_map->slot_at(_index).value; }
+        auto operator++() -> BasicIterator&
+        {
+            _index = IsReversed ? _map->slot_at(_index).previous : _map->slot_at(_index).next;
+            return *this;
+        }
+        auto handle() const -> SlotHandle { return {_index, _map->slot_at(_index).generation}; }
+
+        friend auto operator==(BasicIterator const&, BasicIterator const&) -> bool = default;
+
+    private:
+        friend class SlotMap;
+        BasicIterator(SlotMap* map, uint32_t index)
+            : _map{map}, _index{index}
+        {}
+
+        SlotMap* _map;
+        uint32_t _index;
+    };
+
+public:
+    using Iterator        = BasicIterator<false>;
+    using ReverseIterator = BasicIterator<true>;
+
+    template<typename... Args>
+    auto emplace(Args&&... args) -> SlotHandle
+    {
+        uint32_t const index = allocate_slot();
+        Slot&          slot  = slot_at(index);
+        slot.value.emplace(std::forward<Args>(args)...);
+        link_at_back(index);
+        ++_size;
+        return {index, slot.generation};
+    }
+
+    /// Like emplace(), but the value won't be iterated over until it is passed to move_to_back()
+    template<typename... Args>
+    auto emplace_unlinked(Args&&... args) -> SlotHandle
+    {
+        uint32_t const index = allocate_slot();
+        Slot&          slot  = slot_at(index);
+        slot.value.emplace(std::forward<Args>(args)...);
+        ++_size;
+        return {index, slot.generation};
+    }
+
+    /// Returns nullptr if the value has been erased
+    auto get(SlotHandle handle) -> T*
+    {
+        Slot* const slot = live_slot(handle);
+        return slot != nullptr ? &*slot->value : nullptr;
+    }
+
+    /// Does nothing if the value has already been erased
+    void erase(SlotHandle handle)
+    {
+        Slot* const slot = live_slot(handle);
+        if (slot == nullptr)
+            return;
+        if (slot->is_linked)
+            unlink(handle.index);
+        slot->value.reset();
+        ++slot->generation; // Invalidates all the handles to this slot
+        slot->next  = _first_free;
+        _first_free = handle.index;
+        --_size;
+    }
+
+    /// Moves the value to the end of the iteration order, as if it had just been inserted
+    /// Does nothing if the value has already been erased
+    void move_to_back(SlotHandle handle)
+    {
+        Slot* const slot = live_slot(handle);
+        if (slot == nullptr)
+            return;
+        if (slot->is_linked)
+            unlink(handle.index);
+        link_at_back(handle.index);
+    }
+
+    /// Moves the value just after `previous` in the iteration order, or to the front of it if `previous` is nullopt
+    /// Does nothing if either value has been erased
+    void move_after(SlotHandle handle, std::optional<SlotHandle> previous)
+    {
+        Slot* const slot = live_slot(handle);
+        if (slot == nullptr || (previous && (live_slot(*previous) == nullptr || *previous == handle)))
+            return;
+        if (slot->is_linked)
+            unlink(handle.index);
+        link_after(handle.index, previous ? previous->index : npos);
+    }
+
+    /// Erases the value pointed to by `it`, and returns an iterator to the next value
+    auto erase(Iterator it) -> Iterator
+    {
+        auto next = it;
+        ++next;
+        erase(it.handle());
+        return next;
+    }
+
+    /// Allocates the memory for at least `capacity` values upfront
+    void reserve(size_t capacity)
+    {
+        while (_chunks.size() * chunk_size < capacity)
+            add_chunk();
+    }
+
+    auto begin() -> Iterator { return {this, _first}; }
+    auto end() -> Iterator { return {this, npos}; }
+    auto rbegin() -> ReverseIterator { return {this, _last}; }
+    auto rend() -> ReverseIterator { return {this, npos}; }
+    auto size() const -> size_t { return _size; } // Also counts the values that are not linked
+    auto empty() const -> bool { return _size == 0; }
+
+private:
+    auto slot_at(uint32_t index) -> Slot& { return (*_chunks[index / chunk_size])[index % chunk_size]; }
+
+    auto live_slot(SlotHandle handle) -> Slot*
+    {
+        if (handle.index >= _chunks.size() * chunk_size)
+            return nullptr;
+        Slot& slot = slot_at(handle.index);
+        if (slot.generation != handle.generation || !slot.value.has_value())
+            return nullptr;
+        return &slot;
+    }
+
+    void add_chunk()
+    {
+        // Allocate a new chunk instead of growing a contiguous buffer, so that existing values never move
+        auto const first_index = static_cast<uint32_t>(_chunks.size()) * chunk_size;
+        _chunks.push_back(std::make_unique<std::array<Slot, chunk_size>>());
+        for (uint32_t i = chunk_size; i-- > 0;)
+        {
+            slot_at(first_index + i).next = _first_free;
+            _first_free                   = first_index + i;
+        }
+    }
+
+    auto allocate_slot() -> uint32_t
+    {
+        if (_first_free == npos)
+            add_chunk();
+        uint32_t const index = _first_free;
+        _first_free          = slot_at(index).next;
+        return index;
+    }
+
+    void link_at_back(uint32_t index)
+    {
+        link_after(index, _last);
+    }
+
+    /// Links the slot at the front if `previous` is npos
+    void link_after(uint32_t index, uint32_t previous)
+    {
+        Slot& slot     = slot_at(index);
+        slot.previous  = previous;
+        slot.next      = previous != npos ? slot_at(previous).next : _first;
+        slot.is_linked = true;
+        if (slot.previous != npos)
+            slot_at(slot.previous).next = index;
+        else
+            _first = index;
+        if (slot.next != npos)
+            slot_at(slot.next).previous = index;
+        else
+            _last = index;
+    }
+
+    void unlink(uint32_t index)
+    {
+        Slot& slot     = slot_at(index);
+        slot.is_linked = false;
+        if (slot.previous != npos)
+            slot_at(slot.previous).next = slot.next;
+        else
+            _first = slot.next;
+        if (slot.next != npos)
+            slot_at(slot.next).previous = slot.previous;
+        else
+            _last = slot.previous;
+    }
+
+private:
+    std::vector<std::unique_ptr<std::array<Slot, chunk_size>>> _chunks{};
+    uint32_t                                                   _first{npos};
+    uint32_t                                                   _last{npos};
+    uint32_t                                                   _first_free{npos};
+    size_t                                                     _size{0};
+};
+
+} // namespace ImGuiNotify
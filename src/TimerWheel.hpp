@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace ImGuiNotify {
+
+/// Hashed timer wheel: timers are stored in buckets of `tick` duration, so that finding the expired timers only requires visiting the buckets of the ticks that elapsed since the last call to pop_expired(), instead of all the timers.
+/// Timers are intrusive doubly-linked nodes, so scheduling, rescheduling and cancelling are O(1) and never allocate.
+/// Timers further away than the span of the wheel stay in their bucket and are skipped until their deadline actually comes.
+template<typename T>
+class TimerWheel {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    /// Must be stored in the object that is scheduled, and must not move while it is scheduled
+    class Node {
+    public:
+        explicit Node(T value)
+            : _value{value}
+        {}
+        ~Node()                          = default;
+        Node(Node const&)                = delete;
+        Node& operator=(Node const&)     = delete;
+        Node(Node&&) noexcept            = delete;
+        Node& operator=(Node&&) noexcept = delete;
+
+        auto value() const -> T const& { return _value; }
+        auto is_scheduled() const -> bool { return _is_scheduled; }
+
+    private:
+        friend class TimerWheel;
+        T         _value;
+        TimePoint _deadline{};
+        Node*     _previous{nullptr};
+        Node*     _next{nullptr};
+        size_t    _bucket{0}; // Not necessarily the bucket of the deadline, because deadlines in the past are put in the bucket of the current tick
+        bool      _is_scheduled{false};
+    };
+
+    /// Reschedules the node if it was already scheduled
+    void schedule(Node& node, TimePoint deadline)
+    {
+        cancel(node);
+        int64_t tick = tick_of(deadline);
+        if (_current_tick.has_value())
+            tick = std::max(tick, *_current_tick); // Deadlines in the past will be processed by the next pop_expired()
+        node._bucket       = bucket_index(tick);
+        Node*& head        = _buckets[node._bucket]; // NOLINT(*constant-array-index)
+        node._deadline     = deadline;
+        node._previous     = nullptr;
+        node._next         = head;
+        node._is_scheduled = true;
+        if (head != nullptr)
+            head->_previous = &node;
+        head = &node;
+    }
+
+    /// Does nothing if the node is not scheduled
+    void cancel(Node& node)
+    {
+        if (!node._is_scheduled)
+            return;
+        if (node._previous != nullptr)
+            node._previous->_next = node._next;
+        else
+            _buckets[node._bucket] = node._next; // NOLINT(*constant-array-index)
+        if (node._next != nullptr)
+            node._next->_previous = node._previous;
+        node._previous     = nullptr;
+        node._next         = nullptr;
+        node._is_scheduled = false;
+    }
+
+    /// Unschedules all the nodes whose deadline is <= `now`, and calls `callback(node)` for each of them (the callback is allowed to destroy the node, or to schedule it again)
+    template<typename Callback>
+    void pop_expired(TimePoint now, Callback&& callback)
+    {
+        int64_t const now_tick = tick_of(now);
+        // The first time, we don't know which ticks the nodes have been scheduled for, so we visit all the buckets
+        int64_t const first_tick = _current_tick.has_value() && now_tick - *_current_tick < static_cast<int64_t>(buckets_count)
+                                       ? *_current_tick
+                                       : now_tick - static_cast<int64_t>(buckets_count) + 1;
+        _current_tick = now_tick; // Set before calling the callbacks, so that the nodes they schedule are never put in a bucket we already visited
+
+        for (int64_t tick = first_tick; tick <= now_tick; ++tick)
+        {
+            Node* node = _buckets[bucket_index(tick)]; // NOLINT(*constant-array-index)
+            while (node != nullptr)
+            {
+                Node* const next = node->_next;
+                if (node->_deadline <= now)
+                {
+                    cancel(*node);
+                    callback(*node);
+                }
+                node = next;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t buckets_count{256};
+    static constexpr auto   tick_duration = std::chrono::milliseconds{16};
+
+    static auto tick_of(TimePoint time) -> int64_t
+    {
+        return std::chrono::floor<std::chrono::milliseconds>(time.time_since_epoch()).count() / tick_duration.count();
+    }
+
+    static auto bucket_index(int64_t tick) -> size_t
+    {
+        auto const count = static_cast<int64_t>(buckets_count);
+        return static_cast<size_t>(((tick % count) + count) % count); // Ticks can be negative
+    }
+
+private:
+    std::array<Node*, buckets_count> _buckets{};
+    std::optional<int64_t>           _current_tick{}; // Last tick processed by pop_expired()
+};
+
+} // namespace ImGuiNotify
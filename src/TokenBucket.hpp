@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ImGuiNotify {
+
+/// Lock-free token bucket, implemented with the Generic Cell Rate Algorithm: instead of counting tokens, we store the time at which the bucket will be full again, which can be updated with a single compare-and-swap.
+/// Can be used and reconfigured from any thread.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// `tokens_per_second` <= 0 means there is no limit
+    void configure(float tokens_per_second, int burst)
+    {
+        // Computed in double and clamped, because very low rates would overflow int64_t
+        double const interval = tokens_per_second > 0.f
+                                    ? 1'000'000'000. / static_cast<double>(tokens_per_second)
+                                    : 0.;
+        _interval_ns.store(clamped_duration_ns(interval), std::memory_order_relaxed);
+        _max_delay_ns.store(clamped_duration_ns(interval * std::max(burst, 1)), std::memory_order_relaxed);
+    }
+
+    /// Returns false if the bucket is empty
+    auto try_acquire(Clock::time_point now) -> bool
+    {
+        int64_t const interval = _interval_ns.load(std::memory_order_relaxed);
+        if (interval == 0)
+            return true;
+        int64_t const max_delay = _max_delay_ns.load(std::memory_order_relaxed);
+        int64_t const now_ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+
+        int64_t full_time = _full_time_ns.load(std::memory_order_relaxed);
+        while (true)
+        {
+            int64_t const new_full_time = std::max(full_time, now_ns) + interval;
+            if (new_full_time - now_ns > max_delay)
+                return false;
+            if (_full_time_ns.compare_exchange_weak(full_time, new_full_time, std::memory_order_relaxed))
+                return true;
+        }
+    }
+
+    /// Gives back a token acquired with try_acquire(), e.g. because the notification has been rejected by another bucket
+    void release()
+    {
+        _full_time_ns.fetch_sub(_interval_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    /// Clamped so that adding two of these durations to the current time can't overflow int64_t. That is about 73 years, which is the same as never refilling the bucket anyway.
+    static auto clamped_duration_ns(double duration_ns) -> int64_t
+    {
+        static constexpr int64_t max_duration_ns{INT64_MAX / 4};
+        return static_cast<int64_t>(std::min(duration_ns, static_cast<double>(max_duration_ns)));
+    }
+
+private:
+    std::atomic<int64_t> _interval_ns{0};  // Time it takes to refill one token
+    std::atomic<int64_t> _max_delay_ns{0}; // Time it takes to refill the whole bucket
+    std::atomic<int64_t> _full_time_ns{0}; // Time at which the bucket will be full again
+};
+
+} // namespace ImGuiNotify
@@ -0,0 +1,191 @@
+#include <chrono>
+#include <cstdio>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImGuiNotify/ImGuiNotify.hpp"
+#include "headless_imgui.hpp"
+
+// Every result is printed as one JSON object per line, so that it can easily be parsed to track regressions
+
+using bench_clock = std::chrono::steady_clock;
+
+static auto seconds_since(bench_clock::time_point start) -> double
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+static auto infinite_notification(int i) -> ImGuiNotify::Notification
+{
+    return {
+        .type     = static_cast<ImGuiNotify::Type>(i % 4),
+        .title    = "Job " + std::to_string(i),
+        .content  = "Some details about the job",
+        .duration = std::nullopt,
+    };
+}
+
+/// Closes all the given notifications and runs frames until they are gone, so that each benchmark starts from an empty stack
+static void close_all(HeadlessImGui& imgui, std::vector<ImGuiNotify::NotificationId> const& ids)
+{
+    auto const fade_out_duration               = ImGuiNotify::get_style().fade_out_duration;
+    ImGuiNotify::get_style().fade_out_duration = 0ms;
+    ImGuiNotify::close_immediately_batch(ids);
+    imgui.frame(); // Applies the close commands
+    std::this_thread::sleep_for(1ms);
+    imgui.frame(); // Removes the notifications that were fading out
+    ImGuiNotify::get_style().fade_out_duration = fade_out_duration;
+}
+
+static void bench_send_throughput(HeadlessImGui& imgui, int threads_count, int sends_per_thread)
+{
+    auto ids   = std::vector<std::vector<ImGuiNotify::NotificationId>>(static_cast<size_t>(threads_count));
+    auto latch = std::latch{threads_count + 1};
+
+    auto threads = std::vector<std::thread>{};
+    for (int t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            auto& thread_ids = ids[static_cast<size_t>(t)];
+            thread_ids.reserve(static_cast<size_t>(sends_per_thread));
+            latch.arrive_and_wait();
+            for (int i = 0; i < sends_per_thread; ++i)
+                thread_ids.push_back(ImGuiNotify::send(infinite_notification(i)));
+        });
+    }
+    auto const start = bench_clock::now();
+    latch.arrive_and_wait();
+    for (auto& thread : threads)
+        thread.join();
+    double const seconds = seconds_since(start);
+
+    double const sends = static_cast<double>(threads_count) * static_cast<double>(sends_per_thread);
+    std::printf(R"({"benchmark": "send_throughput", "threads": %d, "sends": %.0f, "seconds": %f, "sends_per_second": %f})" "\n", threads_count, sends, seconds, sends / seconds); // NOLINT(*vararg)
+
+    auto all_ids = std::vector<ImGuiNotify::NotificationId>{};
+    for (auto const& thread_ids : ids)
+        all_ids.insert(all_ids.end(), thread_ids.begin(), thread_ids.end());
+    close_all(imgui, all_ids);
+}
+
+static void bench_send_batch_throughput(HeadlessImGui& imgui, int threads_count, int batches_per_thread, int batch_size)
+{
+    auto ids   = std::vector<std::vector<ImGuiNotify::NotificationId>>(static_cast<size_t>(threads_count));
+    auto latch = std::latch{threads_count + 1};
+
+    auto threads = std::vector<std::thread>{};
+    for (int t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            auto& thread_ids    = ids[static_cast<size_t>(t)];
+            auto  notifications = std::vector<ImGuiNotify::Notification>{};
+            thread_ids.reserve(static_cast<size_t>(batches_per_thread * batch_size));
+            latch.arrive_and_wait();
+            for (int b = 0; b < batches_per_thread; ++b)
+            {
+                notifications.clear();
+                for (int i = 0; i < batch_size; ++i)
+                    notifications.push_back(infinite_notification(i));
+                auto const batch_ids = ImGuiNotify::send_batch(notifications);
+                thread_ids.insert(thread_ids.end(), batch_ids.begin(), batch_ids.end());
+            }
+        });
+    }
+    auto const start = bench_clock::now();
+    latch.arrive_and_wait();
+    for (auto& thread : threads)
+        thread.join();
+    double const seconds = seconds_since(start);
+
+    double const sends = static_cast<double>(threads_count) * static_cast<double>(batches_per_thread) * static_cast<double>(batch_size);
+    std::printf(R"({"benchmark": "send_batch_throughput", "threads": %d, "batch_size": %d, "sends": %.0f, "seconds": %f, "sends_per_second": %f})" "\n", threads_count, batch_size, sends, seconds, sends / seconds); // NOLINT(*vararg)
+
+    auto all_ids = std::vector<ImGuiNotify::NotificationId>{};
+    for (auto const& thread_ids : ids)
+        all_ids.insert(all_ids.end(), thread_ids.begin(), thread_ids.end());
+    close_all(imgui, all_ids);
+}
+
+static void bench_render_windows(HeadlessImGui& imgui, int notifications_count, int frames_count, bool single_window)
+{
+    ImGuiNotify::get_style().single_window = single_window;
+
+    auto ids = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < notifications_count; ++i)
+        ids.push_back(ImGuiNotify::send(infinite_notification(i)));
+    for (int i = 0; i < 10; ++i) // Warm up, and let the notifications finish their fade in
+    {
+        imgui.frame();
+        std::this_thread::sleep_for(30ms);
+    }
+
+    auto render_windows_duration = bench_clock::duration{};
+    auto allocations             = ImGuiNotify::AllocationStats{};
+    for (int i = 0; i < frames_count; ++i)
+    {
+        imgui.frame([&]() {
+            auto const start = bench_clock::now();
+            ImGuiNotify::render_windows();
+            render_windows_duration += bench_clock::now() - start;
+        });
+        allocations.count += ImGuiNotify::last_frame_allocation_stats().count;
+        allocations.bytes += ImGuiNotify::last_frame_allocation_stats().bytes;
+    }
+
+    double const seconds_per_frame     = std::chrono::duration<double>(render_windows_duration).count() / frames_count;
+    double const allocations_per_frame = static_cast<double>(allocations.count) / frames_count;
+    double const bytes_per_frame       = static_cast<double>(allocations.bytes) / frames_count;
+    std::printf(R"({"benchmark": "render_windows", "single_window": %s, "notifications": %d, "frames": %d, "seconds_per_frame": %f, "allocations_per_frame": %f, "allocated_bytes_per_frame": %f})" "\n", single_window ? "true" : "false", notifications_count, frames_count, seconds_per_frame, allocations_per_frame, bytes_per_frame); // NOLINT(*vararg)
+
+    close_all(imgui, ids);
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void bench_change_every_frame(HeadlessImGui& imgui, int notifications_count, int frames_count)
+{
+    auto ids = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < notifications_count; ++i)
+        ids.push_back(ImGuiNotify::send(infinite_notification(i)));
+    imgui.frame();
+
+    auto const start = bench_clock::now();
+    for (int frame = 0; frame < frames_count; ++frame)
+    {
+        imgui.frame([&]() {
+            for (int i = 0; i < notifications_count; ++i)
+            {
+                ImGuiNotify::change(ids[static_cast<size_t>(i)], {
+                    .title    = "Job " + std::to_string(i),
+                    .content  = "Progress: " + std::to_string(frame),
+                    .duration = std::nullopt,
+                });
+            }
+            ImGuiNotify::render_windows();
+        });
+    }
+    double const seconds_per_frame = seconds_since(start) / frames_count;
+    std::printf(R"({"benchmark": "change_every_frame", "notifications": %d, "frames": %d, "seconds_per_frame": %f})" "\n", notifications_count, frames_count, seconds_per_frame); // NOLINT(*vararg)
+
+    close_all(imgui, ids);
+}
+
+auto main() -> int
+{
+    auto imgui = HeadlessImGui{};
+
+    for (int const threads_count : {1, 2, 4, 8})
+        bench_send_throughput(imgui, threads_count, 20'000);
+
+    for (int const threads_count : {1, 2, 4, 8})
+        bench_send_batch_throughput(imgui, threads_count, 200, 100);
+
+    for (bool const single_window : {false, true})
+    {
+        for (int const notifications_count : {10, 100, 1'000, 10'000})
+            bench_render_windows(imgui, notifications_count, 100, single_window);
+    }
+
+    for (int const notifications_count : {10, 100, 1'000})
+        bench_change_every_frame(imgui, notifications_count, 100);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "ImGuiNotify/ImGuiNotify.hpp"
+#include "imgui.h"
+
+/// Dear ImGui context that doesn't need a window nor a GPU: the font atlas is built on the CPU, and the draw data is never sent to a renderer.
+class HeadlessImGui {
+public:
+    explicit HeadlessImGui(ImVec2 display_size = {1920.f, 1080.f})
+    {
+        ImGui::CreateContext();
+        ImGuiIO& io    = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = display_size;
+        io.DeltaTime   = 1.f / 60.f;
+        io.Fonts->AddFontDefault();
+        ImGuiNotify::add_icons_to_current_font();
+        unsigned char* pixels{};
+        int            width{};
+        int            height{};
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height); // Builds the font atlas
+    }
+    ~HeadlessImGui() { ImGui::DestroyContext(); }
+    HeadlessImGui(HeadlessImGui const&)                = delete;
+    HeadlessImGui& operator=(HeadlessImGui const&)     = delete;
+    HeadlessImGui(HeadlessImGui&&) noexcept            = delete;
+    HeadlessImGui& operator=(HeadlessImGui&&) noexcept = delete;
+
+    /// Runs a full ImGui frame, calling `render` between ImGui::NewFrame() and ImGui::Render()
+    template<typename Callback>
+    auto frame(Callback&& render) -> ImDrawData&
+    {
+        ImGui::NewFrame();
+        render();
+        ImGui::Render();
+        return *ImGui::GetDrawData();
+    }
+
+    auto frame() -> ImDrawData&
+    {
+        return frame([]() { ImGuiNotify::render_windows(); });
+    }
+};
@@ -1,11 +1,777 @@
+#include <array>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
 #include "ImGuiNotify/ImGuiNotify.hpp"
+#include "headless_imgui.hpp"
+#include "imgui_internal.h"
 #include "quick_imgui/quick_imgui.hpp"
 
+// Allocations are counted by ImGuiNotify itself, because tests/CMakeLists.txt enables IMGUI_NOTIFY_ALLOCATION_TRACKING
+static auto allocations_count() -> size_t
+{
+    return ImGuiNotify::thread_allocation_stats().count;
+}
+
+// ---Tests that don't need a GPU---
+static int failures_count{0}; // NOLINT(*avoid-non-const-global-variables)
+
+static void check(bool condition, char const* description)
+{
+    if (condition)
+        return;
+    std::fprintf(stderr, "[FAILED] %s\n", description); // NOLINT(*vararg)
+    ++failures_count;
+}
+
+static void test_send_only_allocates_the_queued_command()
+{
+    // Strings that don't fit in the small string buffer, and a lambda that doesn't fit in the small std::function buffer, so that any copy would allocate
+    auto const big_capture  = std::array<int, 32>{};
+    auto       notification = ImGuiNotify::Notification{
+        .title                = "A title that is too long to fit in the small string buffer",
+        .content              = "A content that is too long to fit in the small string buffer",
+        .custom_imgui_content = [big_capture]() { ImGui::Text("%d", big_capture[0]); },
+    };
+
+    size_t const allocations_before = allocations_count();
+    auto const   id                 = ImGuiNotify::send(std::move(notification));
+    check(allocations_count() - allocations_before == 1, "send() allocates exactly once (the queued command), and never copies the notification");
+    ImGuiNotify::close_immediately(id); // So that it doesn't show up during the headless tests
+}
+
+static void test_send_batch_only_allocates_the_queued_commands_and_the_ids()
+{
+    auto notifications = std::vector<ImGuiNotify::Notification>(10, ImGuiNotify::Notification{.title = "A title that is too long to fit in the small string buffer"});
+
+    size_t const allocations_before = allocations_count();
+    auto const   ids                = ImGuiNotify::send_batch(notifications);
+    check(allocations_count() - allocations_before == notifications.size() + 1, "send_batch() allocates once per notification (the queued command), plus once for the ids");
+    ImGuiNotify::close_immediately_batch(ids); // So that they don't show up during the headless tests
+}
+
+// ---Headless tests: they run real frames, but without a window nor a GPU---
+static auto fake_clock() -> ImGuiNotify::ManualTimeSource&
+{
+    static auto instance = ImGuiNotify::ManualTimeSource{};
+    return instance;
+}
+
+/// Moves the fake clock forward, and runs a few frames so that the size of the windows has time to settle
+static auto run_frames_at(HeadlessImGui& imgui, std::chrono::steady_clock::time_point time) -> ImDrawData&
+{
+    fake_clock().set(time);
+    imgui.frame();
+    imgui.frame();
+    return imgui.frame();
+}
+
+static auto notification_windows() -> std::vector<ImGuiWindow*>
+{
+    auto windows = std::vector<ImGuiWindow*>{};
+    for (ImGuiWindow* const window : GImGui->Windows)
+    {
+        if (window->Active && std::string_view{window->Name}.starts_with("##notification"))
+            windows.push_back(window);
+    }
+    return windows;
+}
+
+static auto notification_height() -> float
+{
+    auto const windows = notification_windows();
+    return windows.size() == 1 ? windows[0]->Size.y : -1.f;
+}
+
+static auto notification_height_at(HeadlessImGui& imgui, std::chrono::steady_clock::time_point time) -> float
+{
+    run_frames_at(imgui, time);
+    return notification_height();
+}
+
+static auto has_vertices(ImDrawData const& draw_data) -> bool
+{
+    return draw_data.TotalVtxCount > 0;
+}
+
+static void test_fade_in_and_fade_out(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    ImGuiNotify::send({.title = "Fade", .content = "In and out", .duration = 1s}); // Fade in during 200ms, then stays 1s, then fades out during 200ms
+
+    run_frames_at(imgui, start);
+    float const height_while_fading_in  = notification_height_at(imgui, start + 100ms);
+    float const full_height             = notification_height_at(imgui, start + 700ms);
+    float const height_while_fading_out = notification_height_at(imgui, start + 1300ms);
+    check(has_vertices(run_frames_at(imgui, start + 1300ms)), "A notification that is fading out is still drawn");
+    run_frames_at(imgui, start + 1450ms);
+
+    check(full_height > 0.f, "The notification is visible once it has faded in");
+    check(height_while_fading_in > 0.f && height_while_fading_in < full_height, "The notification is cropped while fading in");
+    check(height_while_fading_out > 0.f && height_while_fading_out < full_height, "The notification is cropped while fading out");
+    check(notification_windows().empty(), "The notification is removed once it has faded out");
+}
+
+static void test_shortening_the_fade_out_reschedules_the_expiry(HeadlessImGui& imgui)
+{
+    auto const start                           = fake_clock().now();
+    ImGuiNotify::get_style().fade_out_duration = 10s;
+    ImGuiNotify::send({.title = "Fade", .duration = 1s});
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms);
+
+    ImGuiNotify::get_style().fade_out_duration = 200ms;
+    run_frames_at(imgui, start + 1500ms);
+    check(notification_windows().empty(), "Shortening the fade out of the style removes the notifications at their new deadline");
+}
+
+static void test_close_after_small_delay(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    auto const id    = ImGuiNotify::send({.title = "Infinite", .duration = std::nullopt});
+
+    run_frames_at(imgui, start);
+    float const full_height = notification_height_at(imgui, start + 500ms);
+    ImGuiNotify::close_after_small_delay(id, 1s); // Fade out will start at 1500ms and end at 1700ms
+    float const height_before_delay     = notification_height_at(imgui, start + 1400ms);
+    float const height_while_fading_out = notification_height_at(imgui, start + 1600ms);
+    run_frames_at(imgui, start + 1750ms);
+
+    check(height_before_delay == full_height, "close_after_small_delay() waits for the delay before closing");
+    check(height_while_fading_out > 0.f && height_while_fading_out < full_height, "close_after_small_delay() fades out after the delay");
+    check(notification_windows().empty(), "close_after_small_delay() removes the notification after the delay and the fade out");
+}
+
+static void test_close_immediately_before_being_shown(HeadlessImGui& imgui)
+{
+    auto const id = ImGuiNotify::send({.title = "Never shown"});
+    ImGuiNotify::close_immediately(id);
+    auto const& draw_data = run_frames_at(imgui, fake_clock().now());
+
+    check(notification_windows().empty() && !has_vertices(draw_data), "A notification closed before being shown never appears");
+}
+
+static void test_hovering_keeps_notification_alive(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    ImGuiNotify::send({.title = "Hover me", .duration = 1s});
+
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms);
+    auto const windows = notification_windows();
+    check(windows.size() == 1, "The notification is shown");
+    if (windows.size() != 1)
+        return;
+    ImVec2 const center{windows[0]->Pos.x + windows[0]->Size.x / 2.f, windows[0]->Pos.y + windows[0]->Size.y / 2.f};
+    ImGui::GetIO().AddMousePosEvent(center.x, center.y);
+    for (auto time = start + 600ms; time <= start + 2000ms; time += 100ms) // Would have expired at 1400ms without hovering
+        run_frames_at(imgui, time);
+    check(notification_windows().size() == 1, "Hovering a notification keeps it alive");
+
+    ImGui::GetIO().AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+    run_frames_at(imgui, start + 3100ms); // Its lifetime restarted when it was last hovered, at 2000ms
+    check(notification_windows().size() == 1, "The lifetime of a notification restarts after it stops being hovered");
+    run_frames_at(imgui, start + 3250ms);
+    check(notification_windows().empty(), "The notification expires once it is no longer hovered");
+}
+
+static void test_deduplication(HeadlessImGui& imgui)
+{
+    auto const start        = fake_clock().now();
+    auto const notification = ImGuiNotify::Notification{.type = ImGuiNotify::Type::Error, .title = "Spam", .content = "Same error again", .duration = 1s, .deduplicate = true};
+    ImGuiNotify::send(notification);
+    ImGuiNotify::send(notification);
+    run_frames_at(imgui, start);
+    check(notification_windows().size() == 1, "Identical notifications are merged into one");
+
+    run_frames_at(imgui, start + 1000ms);
+    auto const id = ImGuiNotify::send(notification); // Resets the lifetime of the existing notification, which would have expired at 1400ms
+    ImGuiNotify::send({.type = ImGuiNotify::Type::Error, .title = "Spam", .content = "A different error", .duration = 1s, .deduplicate = true});
+    run_frames_at(imgui, start + 1000ms);
+    run_frames_at(imgui, start + 1500ms);
+    check(notification_windows().size() == 2, "A duplicate resets the lifetime of the notification, and notifications with a different content are not merged");
+
+    ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 1500ms);
+    run_frames_at(imgui, start + 1750ms);
+    check(notification_windows().size() == 1, "The id of a duplicate refers to the notification it has been merged into");
+    run_frames_at(imgui, start + 3000ms);
+
+    // Only the ids of the most recent duplicates are remembered, so that memory doesn't grow when a notification is spammed
+    ImGuiNotify::send(notification);
+    auto const first_duplicate_id = ImGuiNotify::send(notification);
+    auto       last_duplicate_id  = first_duplicate_id;
+    for (int i = 0; i < 100; ++i)
+        last_duplicate_id = ImGuiNotify::send(notification);
+    run_frames_at(imgui, start + 3000ms);
+    ImGuiNotify::close_immediately(first_duplicate_id);
+    run_frames_at(imgui, start + 3000ms);
+    run_frames_at(imgui, start + 3300ms);
+    check(notification_windows().size() == 1, "The ids of old duplicates are forgotten");
+    ImGuiNotify::close_immediately(last_duplicate_id);
+    run_frames_at(imgui, start + 3300ms);
+    run_frames_at(imgui, start + 3600ms);
+    check(notification_windows().empty(), "The ids of the most recent duplicates are remembered");
+
+    // A notification that has expired but has not been removed yet can't be merged into, so the next duplicates must be merged into the notification that replaces it
+    ImGuiNotify::send(notification);
+    run_frames_at(imgui, start + 3600ms);
+    fake_clock().set(start + 5100ms); // It expired at 5000ms, but will only be removed at the end of the next frame
+    ImGuiNotify::send(notification);
+    imgui.frame();
+    ImGuiNotify::send(notification);
+    run_frames_at(imgui, start + 5100ms);
+    check(notification_windows().size() == 1, "Duplicates are merged into the notification that replaced an expired one");
+    run_frames_at(imgui, start + 7000ms);
+}
+
+static void test_rate_limit(HeadlessImGui& imgui)
+{
+    ImGuiNotify::set_rate_limit("spammy", ImGuiNotify::RateLimit{.notifications_per_second = 0.001f, .burst = 3});
+
+    auto const start = fake_clock().now();
+    for (int i = 0; i < 10; ++i)
+        ImGuiNotify::send({.title = "Spam", .duration = 1s, .source = "spammy"});
+    ImGuiNotify::send({.title = "Not spam", .duration = 1s});
+    run_frames_at(imgui, start);
+    check(notification_windows().size() == 5, "Notifications that exceed the rate limit of their source are dropped, and a summary notification is shown");
+
+    for (int i = 0; i < 10; ++i)
+        ImGuiNotify::send({.title = "More spam", .duration = 1s, .source = "spammy"});
+    run_frames_at(imgui, start + 100ms);
+    check(notification_windows().size() == 5, "All the dropped notifications are reported in the same summary notification");
+
+    ImGuiNotify::set_rate_limit("spammy", std::nullopt);
+    run_frames_at(imgui, start + 10s);
+
+    ImGuiNotify::set_rate_limit("spammy", ImGuiNotify::RateLimit{.notifications_per_second = 0.001f, .burst = 1});
+    ImGuiNotify::set_rate_limit(ImGuiNotify::Type::Warning, ImGuiNotify::RateLimit{.notifications_per_second = 0.001f, .burst = 2});
+    for (int i = 0; i < 10; ++i)
+        ImGuiNotify::send({.type = ImGuiNotify::Type::Warning, .title = "Spam", .duration = 1s, .source = "spammy"});
+    ImGuiNotify::send({.type = ImGuiNotify::Type::Warning, .title = "Not spam", .duration = 1s});
+    run_frames_at(imgui, start + 20s);
+    check(notification_windows().size() == 3, "Notifications dropped by the rate limit of their source don't count towards the rate limit of their type");
+
+    ImGuiNotify::set_rate_limit("spammy", std::nullopt);
+    ImGuiNotify::set_rate_limit(ImGuiNotify::Type::Warning, std::nullopt);
+    run_frames_at(imgui, start + 30s);
+
+    ImGuiNotify::set_rate_limit("very slow", ImGuiNotify::RateLimit{.notifications_per_second = 1e-30f, .burst = 1'000'000'000}); // The interval between two notifications doesn't fit in int64_t nanoseconds
+    for (int i = 0; i < 3; ++i)
+        ImGuiNotify::send({.title = "Very slow", .duration = 1s, .source = "very slow"});
+    run_frames_at(imgui, start + 30s);
+    check(notification_windows().size() == 2, "Rate limits that are too low to be represented behave like a bucket that never refills");
+
+    ImGuiNotify::set_rate_limit("very slow", std::nullopt);
+    run_frames_at(imgui, start + 40s);
+}
+
+static void test_capacity(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    auto const send  = [](ImGuiNotify::Type type, int count) {
+        for (int i = 0; i < count; ++i)
+            ImGuiNotify::send({.type = type, .title = "Over capacity", .duration = 1s});
+    };
+
+    ImGuiNotify::set_capacity({.max_notifications = 3, .overflow_policy = ImGuiNotify::OverflowPolicy::DropOldest});
+    send(ImGuiNotify::Type::Info, 5);
+    run_frames_at(imgui, start);
+    check(notification_windows().size() == 3, "There are never more than max_notifications notifications");
+    run_frames_at(imgui, start + 2s);
+
+    ImGuiNotify::set_capacity({.max_notifications = 3, .overflow_policy = ImGuiNotify::OverflowPolicy::DropLowestPriority});
+    send(ImGuiNotify::Type::Warning, 3);
+    send(ImGuiNotify::Type::Info, 1);
+    send(ImGuiNotify::Type::Error, 1);
+    run_frames_at(imgui, start + 2s);
+    check(notification_windows().size() == 3, "DropLowestPriority keeps the capacity");
+    run_frames_at(imgui, start + 4s);
+
+    ImGuiNotify::set_capacity({.max_notifications = 3, .overflow_policy = ImGuiNotify::OverflowPolicy::MergeIntoSummary});
+    send(ImGuiNotify::Type::Info, 5);
+    run_frames_at(imgui, start + 4s);
+    check(notification_windows().size() == 4, "MergeIntoSummary drops the new notifications and reports them in a summary notification");
+    run_frames_at(imgui, start + 10s);
+
+    ImGuiNotify::set_capacity({.max_notifications = 0, .overflow_policy = ImGuiNotify::OverflowPolicy::MergeIntoSummary});
+    send(ImGuiNotify::Type::Info, 3);
+    run_frames_at(imgui, start + 10s);
+    check(notification_windows().size() == 1, "MergeIntoSummary reports the dropped notifications even when there is no notification that could be dropped instead");
+    run_frames_at(imgui, start + 16s);
+
+    ImGuiNotify::set_capacity({.max_pending_commands = 2, .overflow_policy = ImGuiNotify::OverflowPolicy::RejectNew});
+    send(ImGuiNotify::Type::Info, 5);
+    run_frames_at(imgui, start + 16s);
+    check(notification_windows().size() == 2, "send() is rejected when there are too many pending commands");
+    run_frames_at(imgui, start + 18s);
+
+    ImGuiNotify::set_capacity({});
+}
+
+static void test_priority(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    auto       ids   = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < 50; ++i)
+        ids.push_back(ImGuiNotify::send({.title = "Filling the screen", .duration = std::nullopt}));
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms);
+    check(notification_windows().size() < 50, "Notifications that don't fit on screen are pending");
+
+    auto const error_has_been_shown = std::make_shared<bool>(false);
+    ids.push_back(ImGuiNotify::send({.type = ImGuiNotify::Type::Error, .title = "Important", .custom_imgui_content = [error_has_been_shown]() { *error_has_been_shown = true; }, .duration = std::nullopt}));
+    run_frames_at(imgui, start + 600ms);
+    check(!*error_has_been_shown, "A notification doesn't show up while the screen is full");
+
+    ImGuiNotify::close_immediately(ids[0]);
+    run_frames_at(imgui, start + 600ms);
+    run_frames_at(imgui, start + 900ms);
+    check(*error_has_been_shown, "A notification with a higher priority is shown before the ones that have been pending for longer");
+
+    auto const closed_has_been_shown = std::make_shared<bool>(false);
+    for (int i = 0; i < 100; ++i) // Enough to purge them from the pending notifications
+        ImGuiNotify::close_immediately(ImGuiNotify::send({.type = ImGuiNotify::Type::Error, .title = "Closed while pending", .custom_imgui_content = [closed_has_been_shown]() { *closed_has_been_shown = true; }, .duration = std::nullopt}));
+    size_t const closed_count = 9;
+    for (size_t i = 1; i <= closed_count; ++i)
+        ImGuiNotify::close_immediately(ids[i]);
+    size_t const windows_count_before = notification_windows().size();
+    run_frames_at(imgui, start + 900ms);
+    run_frames_at(imgui, start + 1200ms);
+    check(!*closed_has_been_shown && notification_windows().size() > windows_count_before - closed_count, "Notifications closed while pending never show up, and the other pending notifications take their room");
+
+    for (auto const& id : ids)
+        ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 1200ms);
+    run_frames_at(imgui, start + 1500ms);
+}
+
+static void test_priority_in_single_window(HeadlessImGui& imgui)
+{
+    ImGuiNotify::get_style().single_window = true;
+
+    auto const start = fake_clock().now();
+    auto       ids   = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < 50; ++i)
+        ids.push_back(ImGuiNotify::send({.title = "Filling the screen", .duration = std::nullopt}));
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms);
+
+    auto const error_has_been_shown = std::make_shared<bool>(false);
+    ids.push_back(ImGuiNotify::send({.type = ImGuiNotify::Type::Error, .title = "Important", .custom_imgui_content = [error_has_been_shown]() { *error_has_been_shown = true; }, .duration = std::nullopt}));
+    run_frames_at(imgui, start + 600ms);
+    check(*error_has_been_shown, "In single window mode, a notification with a higher priority is stacked where it is visible, even when the others overflow");
+
+    for (auto const& id : ids)
+        ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 600ms);
+    run_frames_at(imgui, start + 900ms);
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void test_batch(HeadlessImGui& imgui)
+{
+    auto const start         = fake_clock().now();
+    auto       notifications = std::vector<ImGuiNotify::Notification>(3, ImGuiNotify::Notification{.title = "Batch", .duration = std::nullopt});
+    auto const ids           = ImGuiNotify::send_batch(notifications);
+    run_frames_at(imgui, start);
+    check(ids.size() == 3 && notification_windows().size() == 3, "send_batch() sends all the notifications");
+
+    auto changes = std::vector<ImGuiNotify::Notification>(3, ImGuiNotify::Notification{.title = "Changed", .duration = std::nullopt});
+    ImGuiNotify::change_batch(ids, changes);
+    ImGuiNotify::close_after_small_delay_batch(std::span{ids}.first(2), 100ms);
+    run_frames_at(imgui, start + 100ms);
+    run_frames_at(imgui, start + 600ms);
+    check(notification_windows().size() == 1, "close_after_small_delay_batch() closes all the given notifications");
+
+    ImGuiNotify::close_immediately_batch(ids);
+    run_frames_at(imgui, start + 600ms);
+    run_frames_at(imgui, start + 900ms);
+    check(notification_windows().empty(), "close_immediately_batch() closes all the given notifications");
+}
+
+static void test_progress(HeadlessImGui& imgui)
+{
+    auto const start    = fake_clock().now();
+    auto const progress = ImGuiNotify::make_progress();
+    auto const id       = ImGuiNotify::send({.title = "Downloading", .duration = std::nullopt, .progress = progress});
+    run_frames_at(imgui, start + 500ms);
+    float const height = notification_height();
+
+    std::thread{[&]() { progress->store(0.5f); }}.join();
+    imgui.frame();
+    check(ImGuiNotify::last_frame_allocation_stats().count == 0, "Updating the progress doesn't go through the queue of commands, and doesn't allocate");
+    check(notification_height() == height, "Updating the progress doesn't trigger a change transition");
+
+    ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 500ms);
+    run_frames_at(imgui, start + 800ms);
+}
+
+static void test_partial_updates(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    auto const id    = ImGuiNotify::send({.title = "Partial", .content = "One line", .duration = std::nullopt});
+    run_frames_at(imgui, start);
+    float const height = notification_height_at(imgui, start + 500ms);
+
+    ImGuiNotify::set_type(id, ImGuiNotify::Type::Success);
+    check(notification_height_at(imgui, start + 550ms) == height, "set_type() doesn't trigger a change transition");
+
+    ImGuiNotify::set_content(id, "One word");
+    check(notification_height_at(imgui, start + 550ms) == height && !ImGuiNotify::next_required_frame_time().has_value(), "set_content() doesn't animate the notification when its height doesn't change");
+
+    ImGuiNotify::set_content(id, "One line\nTwo lines\nThree lines");
+    run_frames_at(imgui, start + 600ms);
+    float const height_during_transition = notification_height_at(imgui, start + 700ms);
+    float const height_after_transition  = notification_height_at(imgui, start + 1000ms);
+    check(height_during_transition > height && height_during_transition < height_after_transition, "set_content() animates the height of the notification");
+
+    ImGuiNotify::set_duration(id, 1s); // Its lifetime has last been reset by set_content() at 600ms, so it disappears at 600ms + 1s + fade out
+    run_frames_at(imgui, start + 1000ms);
+    check(notification_windows().size() == 1, "set_duration() doesn't reset the lifetime of the notification");
+    run_frames_at(imgui, start + 1850ms);
+    check(notification_windows().empty(), "set_duration() changes how long the notification stays visible");
+}
+
+static void test_commands_are_coalesced(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    auto const id    = ImGuiNotify::send({.title = "Coalesced", .duration = std::nullopt});
+    run_frames_at(imgui, start + 500ms);
+
+    auto const superseded_change_has_been_shown = std::make_shared<bool>(false);
+    for (int i = 0; i < 50; ++i)
+        ImGuiNotify::change(id, {.title = "Superseded", .custom_imgui_content = [superseded_change_has_been_shown]() { *superseded_change_has_been_shown = true; }, .duration = std::nullopt});
+    ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 500ms);
+    run_frames_at(imgui, start + 800ms);
+    check(notification_windows().empty(), "The notification is closed");
+    check(!*superseded_change_has_been_shown, "A close supersedes the changes that were pending before it");
+
+    auto const revived_id = ImGuiNotify::send({.title = "Revived", .duration = std::nullopt});
+    run_frames_at(imgui, start + 1s);
+    ImGuiNotify::close_after_small_delay(revived_id, 100ms);
+    ImGuiNotify::change(revived_id, {.title = "Revived", .content = "By a change", .duration = std::nullopt});
+    run_frames_at(imgui, start + 1s);
+    run_frames_at(imgui, start + 2s);
+    check(notification_windows().size() == 1, "A change that comes after a close_after_small_delay() cancels the close, like when the commands are not coalesced");
+    ImGuiNotify::close_immediately(revived_id);
+    run_frames_at(imgui, start + 2s);
+    run_frames_at(imgui, start + 2500ms);
+
+    auto const duplicate = ImGuiNotify::Notification{.title = "Duplicate", .duration = std::nullopt, .deduplicate = true};
+    ImGuiNotify::send(duplicate);
+    run_frames_at(imgui, start + 3s);
+    ImGuiNotify::close_immediately(ImGuiNotify::send(duplicate));
+    run_frames_at(imgui, start + 3s);
+    run_frames_at(imgui, start + 3500ms);
+    check(notification_windows().empty(), "Closing a duplicate in the same frame as it is sent closes the notification it has been merged into");
+}
+
+static void test_next_required_frame_time(HeadlessImGui& imgui)
+{
+    auto const start = fake_clock().now();
+    ImGuiNotify::send({.title = "Wake me up", .duration = 1s});
+
+    run_frames_at(imgui, start);
+    check(ImGuiNotify::next_required_frame_time() == start, "Frames are required while the notification fades in");
+    run_frames_at(imgui, start + 500ms);
+    check(ImGuiNotify::next_required_frame_time() == start + 1200ms, "Once the notification is static, the next frame is only required when it starts fading out");
+    run_frames_at(imgui, start + 1300ms);
+    check(ImGuiNotify::next_required_frame_time() == start + 1300ms, "Frames are required while the notification fades out");
+    run_frames_at(imgui, start + 1500ms);
+    check(!ImGuiNotify::next_required_frame_time().has_value(), "No frame is required once all the notifications are gone");
+}
+
+static void test_single_window(HeadlessImGui& imgui)
+{
+    ImGuiNotify::get_style().single_window = true;
+
+    auto const start = fake_clock().now();
+    for (int i = 0; i < 3; ++i)
+        ImGuiNotify::send({.title = "In a single window", .duration = 1s});
+
+    auto const&        draw_data   = run_frames_at(imgui, start + 500ms);
+    ImGuiWindow* const host_window = ImGui::FindWindowByName("##ImGuiNotify");
+    check(host_window != nullptr && host_window->Active, "All notifications are rendered in the host window");
+    check(notification_windows().empty(), "No window is created per notification");
+    check(has_vertices(draw_data), "The notifications are drawn in the host window");
+
+    run_frames_at(imgui, start + 1450ms);
+    check(host_window == nullptr || !host_window->Active, "The host window disappears once all notifications have expired");
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void test_single_window_only_renders_visible_notifications(HeadlessImGui& imgui)
+{
+    ImGuiNotify::get_style().single_window = true;
+
+    auto const start = fake_clock().now();
+    auto       ids   = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < 1000; ++i)
+        ids.push_back(ImGuiNotify::send({.title = "One of many", .content = "Only a few of us fit on screen", .duration = std::nullopt}));
+
+    auto const&        draw_data   = run_frames_at(imgui, start + 500ms);
+    ImGuiWindow* const host_window = ImGui::FindWindowByName("##ImGuiNotify");
+    check(host_window != nullptr && host_window->ScrollMax.y > 0.f, "Notifications that don't fit on screen can be scrolled to");
+    check(draw_data.TotalVtxCount < 20'000, "Only the notifications that are visible are rendered");
+
+    for (auto const& id : ids)
+        ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 500ms);
+    run_frames_at(imgui, start + 1000ms);
+    check(host_window == nullptr || !host_window->Active, "All the notifications can be closed");
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void test_single_window_only_updates_the_cards_that_change(HeadlessImGui& imgui)
+{
+    ImGuiNotify::get_style().single_window = true;
+
+    auto const start = fake_clock().now();
+    auto       ids   = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < 200; ++i)
+        ids.push_back(ImGuiNotify::send({.title = "One of many", .duration = std::nullopt}));
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms);
+    ImGuiWindow* const host_window    = ImGui::FindWindowByName("##ImGuiNotify");
+    float const        content_height = host_window->ContentSize.y;
+    check(!ImGuiNotify::next_required_frame_time().has_value(), "In single window mode, no frame is required once all the cards are static");
+
+    ImGuiNotify::close_immediately(ids.back()); // The newest one, at the top, which is not visible
+    run_frames_at(imgui, start + 500ms);
+    run_frames_at(imgui, start + 600ms);
+    check(host_window->ContentSize.y < content_height, "Closing a card that is not visible shrinks the scrollable area");
+    float const content_height_after_close = host_window->ContentSize.y;
+
+    ImGuiNotify::set_title(ids.front(), "One of many, with a title that is long enough to be wrapped on several lines"); // The oldest one, at the bottom, which is visible
+    run_frames_at(imgui, start + 600ms);
+    run_frames_at(imgui, start + 1000ms);
+    run_frames_at(imgui, start + 1100ms);
+    check(host_window->ContentSize.y > content_height_after_close, "A card that changes updates the height of the scrollable area");
+
+    for (auto const& id : ids)
+        ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 1100ms);
+    run_frames_at(imgui, start + 1600ms);
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+struct Vertex {
+    ImVec2 position;
+    ImVec2 uv;
+    ImU32  color;
+
+    friend auto operator==(Vertex const& a, Vertex const& b) -> bool
+    {
+        return a.position.x == b.position.x && a.position.y == b.position.y && a.uv.x == b.uv.x && a.uv.y == b.uv.y && a.color == b.color;
+    }
+};
+
+/// The vertices of all the triangles drawn during a frame, in drawing order, to check that two frames look exactly the same even if their vertex and index buffers are not laid out the same way
+static auto drawn_vertices(ImDrawData const& draw_data) -> std::vector<Vertex>
+{
+    auto vertices = std::vector<Vertex>{};
+    for (ImDrawList const* const draw_list : draw_data.CmdLists)
+    {
+        for (ImDrawCmd const& command : draw_list->CmdBuffer)
+        {
+            for (unsigned int i = command.IdxOffset; i < command.IdxOffset + command.ElemCount; ++i)
+            {
+                ImDrawVert const& vertex = draw_list->VtxBuffer[static_cast<int>(command.VtxOffset + draw_list->IdxBuffer[static_cast<int>(i)])];
+                vertices.push_back({vertex.pos, vertex.uv, vertex.col});
+            }
+        }
+    }
+    return vertices;
+}
+
+static void test_static_notifications_reuse_their_layout(HeadlessImGui& imgui, bool single_window)
+{
+    ImGuiNotify::get_style().single_window = single_window;
+
+    auto const start = fake_clock().now();
+    auto const id    = ImGuiNotify::send({.title = "Static", .content = "Nothing changes", .duration = std::nullopt});
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms);
+    auto const  cached_vertices = drawn_vertices(imgui.frame()); // Rendered with the layout and geometry cached during the previous frames
+    float const height          = notification_height();
+
+    ImGuiNotify::get_style().reuse_static_layouts = false;
+    auto const measured_vertices = drawn_vertices(imgui.frame());
+    check(cached_vertices == measured_vertices && notification_height() == height, single_window ? "A static notification looks the same when it reuses its layout and geometry (single window)" : "A static notification looks the same when it reuses its layout and geometry (one window per notification)");
+    ImGuiNotify::get_style().reuse_static_layouts = true;
+
+    if (!single_window)
+    {
+        ImGuiNotify::set_content(id, "One line\nTwo lines\nThree lines");
+        check(notification_height_at(imgui, start + 1000ms) > height, "Changing a notification invalidates its layout and geometry");
+    }
+
+    ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 1000ms);
+    run_frames_at(imgui, start + 1500ms);
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void test_content_is_wrapped_again_when_the_width_changes(HeadlessImGui& imgui)
+{
+    ImGuiNotify::get_style().single_window = true; // The cards have exactly Style::min_width as their width
+
+    auto const start       = fake_clock().now();
+    auto const id          = ImGuiNotify::send({.title = "Build failed", .content = "error: no matching function for call to 'foo(int)'. note: candidate 'void foo(std::string const&)' is not viable: no known conversion from 'int' to 'std::string const&' for the first argument", .duration = std::nullopt});
+    auto const card_height = [&](std::chrono::steady_clock::time_point time) {
+        run_frames_at(imgui, time);
+        ImGuiWindow* const host_window = ImGui::FindWindowByName("##ImGuiNotify");
+        return host_window != nullptr ? host_window->Size.y : -1.f;
+    };
+    run_frames_at(imgui, start);
+    float const narrow_height = card_height(start + 500ms);
+
+    ImGuiNotify::get_style().min_width *= 2.f;
+    check(card_height(start + 500ms) < narrow_height, "The content is wrapped again when the width of the notification changes");
+    ImGuiNotify::get_style().min_width /= 2.f;
+    check(card_height(start + 500ms) == narrow_height, "The content is wrapped like before once the width is restored");
+
+    ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 500ms);
+    run_frames_at(imgui, start + 1000ms);
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void test_cached_wrapping_draws_like_imgui(HeadlessImGui& imgui)
+{
+    ImGuiNotify::get_style().single_window = true; // The cards have exactly Style::min_width as their width, so both notifications are drawn at the same place
+
+    auto const drawn_at_steady_state = [&](ImGuiNotify::Notification notification) {
+        auto const start = fake_clock().now();
+        auto const id    = ImGuiNotify::send(std::move(notification));
+        run_frames_at(imgui, start);
+        auto vertices = drawn_vertices(run_frames_at(imgui, start + 500ms));
+        ImGuiNotify::close_immediately(id);
+        run_frames_at(imgui, start + 500ms);
+        run_frames_at(imgui, start + 1000ms);
+        return vertices;
+    };
+
+    for (char const* const text : {
+             "First line\nSecond line, which is long enough to be wrapped at least once by the notification",
+             "Blank lines\n\n\nin the middle",
+             "Lots of blanks:          which          must          be          skipped          at          the          wrap          points",
+             "Lots of blanks before a newline, exactly where the text is wrapped                                                  \nNext line",
+             "A_word_that_is_much_wider_than_the_notification_itself_so_that_it_is_cut_in_the_middle and then some text",
+             "Trailing newline\n",
+         })
+    {
+        auto const cached_vertices = drawn_at_steady_state({.title = "Wrapped", .content = text, .duration = std::nullopt});
+        auto const imgui_vertices  = drawn_at_steady_state({.title = "Wrapped", .custom_imgui_content = [text]() { ImGui::TextUnformatted(text); }, .duration = std::nullopt});
+        check(!cached_vertices.empty() && cached_vertices == imgui_vertices, "The cached wrapping draws the text exactly like ImGui::TextUnformatted() inside ImGui::PushTextWrapPos()");
+    }
+
+    ImGui::GetIO().FontGlobalScale = 1.25f; // The font size has a fractional part, so lines are not a whole number of pixels apart
+    for (char const* const text : {
+             "First line\nSecond line, which is long enough to be wrapped at least once by the notification, and then a few more times by the notification",
+             "Trailing newline\n",
+         })
+    {
+        auto const cached_vertices = drawn_at_steady_state({.title = "Wrapped", .content = text, .duration = std::nullopt});
+        auto const imgui_vertices  = drawn_at_steady_state({.title = "Wrapped", .custom_imgui_content = [text]() { ImGui::TextUnformatted(text); }, .duration = std::nullopt});
+        check(!cached_vertices.empty() && cached_vertices == imgui_vertices, "The cached wrapping draws the text exactly like ImGui::TextUnformatted() inside ImGui::PushTextWrapPos(), even when the font size is fractional");
+    }
+    ImGui::GetIO().FontGlobalScale = 1.f;
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void test_steady_state_frame_does_not_allocate(HeadlessImGui& imgui, bool single_window)
+{
+    ImGuiNotify::get_style().single_window = single_window;
+
+    auto const start = fake_clock().now();
+    auto       ids   = std::vector<ImGuiNotify::NotificationId>{};
+    for (int i = 0; i < 20; ++i) // Enough that some ids have several digits
+        ids.push_back(ImGuiNotify::send({.title = "Steady", .content = "Nothing changes", .duration = std::nullopt}));
+    run_frames_at(imgui, start);
+    run_frames_at(imgui, start + 500ms); // Done fading in, so the layouts and geometries have been cached
+
+    size_t const allocations_before = allocations_count();
+    imgui.frame();
+    check(allocations_count() == allocations_before, single_window ? "A steady state frame doesn't allocate (single window)" : "A steady state frame doesn't allocate (one window per notification)");
+    check(ImGuiNotify::last_frame_allocation_stats().count == 0 && ImGuiNotify::last_frame_allocation_stats().bytes == 0, "last_frame_allocation_stats() reports no allocation for a steady state frame");
+
+    for (auto const& id : ids)
+        ImGuiNotify::close_immediately(id);
+    run_frames_at(imgui, start + 500ms);
+    run_frames_at(imgui, start + 1000ms);
+
+    ImGuiNotify::get_style().single_window = false;
+}
+
+static void run_headless_tests()
+{
+    auto imgui = HeadlessImGui{};
+    ImGuiNotify::set_time_source(fake_clock().time_source());
+
+    // Every headless test expects to be the only one with notifications on screen, so a notification leaked by a previous test would make all of them fail
+    run_frames_at(imgui, fake_clock().now());
+    check(notification_windows().empty(), "The headless tests start without any notification");
+
+    test_fade_in_and_fade_out(imgui);
+    test_shortening_the_fade_out_reschedules_the_expiry(imgui);
+    test_close_after_small_delay(imgui);
+    test_close_immediately_before_being_shown(imgui);
+    test_hovering_keeps_notification_alive(imgui);
+    test_deduplication(imgui);
+    test_rate_limit(imgui);
+    test_capacity(imgui);
+    test_priority(imgui);
+    test_priority_in_single_window(imgui);
+    test_batch(imgui);
+    test_progress(imgui);
+    test_partial_updates(imgui);
+    test_commands_are_coalesced(imgui);
+    test_next_required_frame_time(imgui);
+    test_single_window(imgui);
+    test_single_window_only_renders_visible_notifications(imgui);
+    test_single_window_only_updates_the_cards_that_change(imgui);
+    test_static_notifications_reuse_their_layout(imgui, false);
+    test_static_notifications_reuse_their_layout(imgui, true);
+    test_content_is_wrapped_again_when_the_width_changes(imgui);
+    test_cached_wrapping_draws_like_imgui(imgui);
+    test_steady_state_frame_does_not_allocate(imgui, false);
+    test_steady_state_frame_does_not_allocate(imgui, true);
+
+    ImGuiNotify::set_time_source({});
+}
+
+static void run_tests_that_dont_need_a_gpu()
+{
+    test_send_only_allocates_the_queued_command();
+    test_send_batch_only_allocates_the_queued_commands_and_the_ids();
+    run_headless_tests();
+}
+
 auto main(int argc, char* argv[]) -> int
 {
     bool const should_run_imgui_tests = argc < 2 || strcmp(argv[1], "-nogpu") != 0; // NOLINT(*pointer-arithmetic)
     if (!should_run_imgui_tests)
-        return 0;
+    {
+        run_tests_that_dont_need_a_gpu();
+        return failures_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
     quick_imgui::loop(
         "ImGuiNotify tests",